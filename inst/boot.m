@@ -6,6 +6,9 @@
 % -- Function File: BOOTSAM = boot (..., NBOOT, LOO)
 % -- Function File: BOOTSAM = boot (..., NBOOT, LOO, SEED)
 % -- Function File: BOOTSAM = boot (..., NBOOT, LOO, SEED, WEIGHTS)
+% -- Function File: boot (..., NBOOT, LOO, SEED, WEIGHTS, FILENAME)
+% -- Function File: [BOOTSAM, INFO] = boot (...)
+% -- Function File: INFO = boot ('profile')
 %
 %     'BOOTSAM = boot (N, NBOOT)' generates NBOOT bootstrap samples of length N.
 %     The samples generated are composed of indices within the range 1:N, which
@@ -54,6 +57,42 @@
 %     corresponding index (or element in X) is represented in BOOTSAM.
 %     Therefore, the sum of WEIGHTS must equal N * NBOOT. 
 %
+%     'boot (..., NBOOT, LOO, SEED, WEIGHTS, FILENAME)' writes BOOTSAM to the
+%     file FILENAME instead of returning it. The boot MEX file writes each
+%     column (i.e. bootstrap sample) to the file as soon as it is generated, so
+%     that the whole of BOOTSAM is never held in memory. Indices are stored as
+%     unsigned integers of the smallest width (8, 16 or 32 bits) that can hold
+%     N, whereas values of X are stored as doubles. Any range of columns can be
+%     read back from the file using the 'bootread' function (see also help for
+%     the 'bootwrite' function).
+%
+%     '[BOOTSAM, INFO] = boot (...)' also instruments the call and returns a
+%     structure, INFO, with the following fields:
+%        o calls: the number of calls profiled (i.e. 1)
+%        o validation, allocation, rng, search, write and total: the time (in
+%          seconds) spent on validation of the input arguments, allocation of
+%          BOOTSAM (or opening of FILENAME), drawing random numbers, searching
+%          for the sampled indices and putting them in BOOTSAM, writing to
+%          FILENAME, and in total
+%        o draws: the number of random numbers drawn
+%        o search_steps: the number of steps of the searches for the sampled
+%          indices
+%        o bytes_allocated and bytes_written: the number of bytes allocated
+%          and written to FILENAME
+%     BOOTSAM is empty if it is written to FILENAME.
+%
+%     'INFO = boot ('profile')' returns the sum of the counters and timings in
+%     INFO over all calls to boot since the totals were last returned, and then
+%     resets them. The totals are only recorded if the environment variable
+%     STATISTICS_RESAMPLING_PROFILE is set (to a value other than 0) before the
+%     calls, so that the time spent in boot by functions that call it (such as
+%     bootknife and bootlm) can be attributed without external profilers, e.g.:
+%            setenv ('STATISTICS_RESAMPLING_PROFILE', '1');
+%            boot ('profile');   % reset the totals
+%            bootknife (randn (99, 1), 1999);
+%            INFO = boot ('profile')
+%     The instrumentation does not change BOOTSAM.
+%
 %  Bibliography:
 %  [1] Efron, and Tibshirani (1993) An Introduction to the
 %        Bootstrap. New York, NY: Chapman & Hall
@@ -65,7 +104,7 @@
 %        vs. Smoothing; Proceedings of the Section on Statistics & the 
 %        Environment. Alexandria, VA: American Statistical Association.
 %
-%  boot (version 2024.04.24)
+%  boot (version 2026.10.17)
 %  Author: Andrew Charles Penn
 %  https://www.researchgate.net/profile/Andrew_Penn/
 %
@@ -83,7 +122,43 @@
 %  You should have received a copy of the GNU General Public License
 %  along with this program.  If not, see http://www.gnu.org/licenses/
 
-function bootsam = boot (x, nboot, loo, s, w)
+function [bootsam, info] = boot (x, nboot, loo, s, w, filename)
+
+  % Running totals of the instrumentation of calls to boot
+  persistent totals
+  if (isempty (totals))
+    totals = newprofile ();
+  end
+
+  % Return (and reset) the running totals of the instrumentation
+  if ((nargin == 1) && ischar (x))
+    if (~ strcmp (x, 'profile'))
+      error ('boot: The only valid string input argument is ''profile''.')
+    end
+    bootsam = totals;
+    totals = newprofile ();
+    return
+  end
+
+  % Start the clock (the call is instrumented if INFO is requested, or if the
+  % environment variable STATISTICS_RESAMPLING_PROFILE is set)
+  env = getenv ('STATISTICS_RESAMPLING_PROFILE');
+  accumulate = (~ isempty (env) && ~ strcmp (env, '0'));
+  info = newprofile ();
+  t0 = tic;
+
+  % Check if BOOTSAM is to be written to a file
+  if ((nargin > 5) && ~ isempty (filename))
+    if (~ ischar (filename))
+      error (cat (2, 'boot: The sixth input argument (FILENAME) must be a', ...
+                     ' character array.'))
+    end
+    if (nargout == 1)
+      error ('boot: BOOTSAM is not returned when it is written to FILENAME.')
+    end
+  else
+    filename = [];
+  end
 
   % Input variables
   n = numel(x);
@@ -123,10 +198,16 @@ function bootsam = boot (x, nboot, loo, s, w)
     rand ('twister', s);
   end
 
+  info.validation = toc (t0);
+
   % Preallocate bootsam
+  t = tic;
   bootsam = zeros (n, nboot);
+  info.allocation = toc (t);
+  info.bytes_allocated = 8 * n * (nboot + 1);
 
   % Initialize weight vector defining the available row counts remaining
+  t = tic;
   if ((nargin > 4) && ~ isempty (w))
     % Assign user defined weights (counts)
     % Error checking
@@ -142,6 +223,7 @@ function bootsam = boot (x, nboot, loo, s, w)
     % Assign weights (counts) for uniform sampling
     c = ones (n, 1) * nboot; 
   end
+  info.validation = info.validation + toc (t);
 
   % Initialize
   N = sum (c);
@@ -153,13 +235,18 @@ function bootsam = boot (x, nboot, loo, s, w)
     r = b - fix ((b - 1) / n) * n;                        % systematic
     nr = sum ((fix ((b - 1) / n) == fix (nboot / n)));
     r(end - nr + 1 : end)  = 1 + fix (rand (1, nr) * n);  % random
+    info.draws = nr;
   end
 
   % Perform balanced sampling
   for b = 1:nboot
 
     % Create n pseudo-random numbers for resample number b
+    t = tic;
     R = rand (1, n);
+    info.rng = info.rng + toc (t);
+    info.draws = info.draws + n;
+    t = tic;
 
     % Re-evaluate whether to use vectorized resampling. The resampling is only
     % vectorized when the count (c) for each of the indices is >= n
@@ -214,6 +301,8 @@ function bootsam = boot (x, nboot, loo, s, w)
     else
       bootsam (:, b) = j;
     end
+    info.search = info.search + toc (t);
+    info.search_steps = info.search_steps + n * n;
 
     % Additional steps relevant to bootknife resampling only
     if (loo)
@@ -223,6 +312,51 @@ function bootsam = boot (x, nboot, loo, s, w)
 
   end
 
+  % Write BOOTSAM to file
+  if (~ isempty (filename))
+    t = tic;
+    if (isvec)
+      bootwrite (filename, bootsam, 'double');
+      width = 8;
+    elseif (n <= 255)
+      bootwrite (filename, bootsam, 'uint8');
+      width = 1;
+    elseif (n <= 65535)
+      bootwrite (filename, bootsam, 'uint16');
+      width = 2;
+    else
+      bootwrite (filename, bootsam, 'uint32');
+      width = 4;
+    end
+    info.write = toc (t);
+    info.bytes_written = 32 + width * n * nboot;
+    if (nargout > 1)
+      bootsam = [];
+    else
+      clear bootsam
+    end
+  end
+
+  % Return and/or accumulate the instrumentation
+  info.calls = 1;
+  info.total = toc (t0);
+  if (accumulate)
+    fields = fieldnames (info);
+    for i = 1:numel (fields)
+      totals.(fields{i}) = totals.(fields{i}) + info.(fields{i});
+    end
+  end
+
+%--------------------------------------------------------------------------
+
+function info = newprofile ()
+
+  % Helper subfunction to create a structure of instrumentation counters and
+  % timings that are all zero
+  info = struct ('calls', 0, 'validation', 0, 'allocation', 0, 'rng', 0, ...
+                 'search', 0, 'write', 0, 'total', 0, 'draws', 0, ...
+                 'search_steps', 0, 'bytes_allocated', 0, 'bytes_written', 0);
+
 %!demo
 %!
 %! % N as input; balanced bootstrap resampling with replacement
@@ -306,3 +440,12 @@ function bootsam = boot (x, nboot, loo, s, w)
 %! % Test feature for changing resampling weights when LOO is true
 %! I = boot (3, 20, true, 1, [30,30,0]);
 %! assert (any (I(:) == 3), false);
+
+%!test
+%! % Test that the instrumentation does not change the resamples
+%! I1 = boot (5, 20, true, 1);
+%! [I2, info] = boot (5, 20, true, 1);
+%! assert (I1, I2);
+%! assert (info.calls, 1);
+%! assert (info.draws >= 100);
+%! assert (info.total >= 0);
@@ -412,19 +412,51 @@ function [pval, c, stats, Q] = boot1way (data, group, varargin)
     end
   end
 
-  % Create maxstat anonymous function for bootstrap
-  func = @(data) parsubfun.maxstat (data, g, nboot(2), bootfun, ref, ISOCTAVE);
+  % Sort the rows by group once so that the rows of each group are a contiguous
+  % block of ord, and get the row indices (rows) and sample size (nk) of each
+  % group
+  [jnk, ord] = sort (g(:));
+  nk = accumarray (g(:), 1);
+  rows = mat2cell (ord, nk, 1);
+
+  % Check whether bootfun is vectorized
+  if (nvar > 1)
+    vectorized = false;
+  else
+    try
+      x = data(rows{1});
+      chk = bootfun (cat (2, x, x));
+      vectorized = (all (size (chk) == [1, 2]) && all (chk == bootfun (x)));
+    catch
+      vectorized = false;
+    end
+  end
 
   % Perform resampling and calculate bootstrap statistics to estimate the 
   % sampling distribution under the null hypothesis.
   % LOO set to false for bootstrap (instead of bootknife) resampling.
   boot (1, 1, false, 1); % set random seed to make resampling deterministic
-  if (paropt.UseParallel)
-    [jnk, Q] = bootknife (data, nboot(1), func, NaN, [], paropt.nproc, ...
-                          [], [], ISOCTAVE, true, false);
+  if (vectorized)
+    % Vectorized calculation of the maximum test statistic for all of the
+    % bootstrap resamples at once. Random numbers are drawn in the same order
+    % as when bootknife evaluates maxstat on the DATA and then on each resample
+    T0 = vmaxstat (data, ord, nk, nboot(2), bootfun, ref);
+    if (isnan (T0))
+      error ('boot1way: BOOTFUN returned NaN with the DATA provided')
+    end
+    Q = vmaxstat (boot (data, nboot(1), false), ord, nk, nboot(2), ...
+                  bootfun, ref);
   else
-    [jnk, Q] = bootknife (data, nboot(1), func, NaN, [], 0, ...
-                          [], [], ISOCTAVE, true, false);
+    % Create maxstat anonymous function for bootstrap
+    func = @(data) parsubfun.maxstat (data, rows, nboot(2), bootfun, ref, ...
+                                      ISOCTAVE);
+    if (paropt.UseParallel)
+      [jnk, Q] = bootknife (data, nboot(1), func, NaN, [], paropt.nproc, ...
+                            [], [], ISOCTAVE, true, false);
+    else
+      [jnk, Q] = bootknife (data, nboot(1), func, NaN, [], 0, ...
+                            [], [], ISOCTAVE, true, false);
+    end
   end
   
   % Compute the estimate (theta) and it's pooled (weighted mean) sampling
@@ -432,20 +464,18 @@ function [pval, c, stats, Q] = boot1way (data, group, varargin)
   theta = zeros (k, 1);
   SE = zeros (k, 1);
   Var = zeros (k, 1);
-  nk = zeros (size(gk));
   for j = 1:k
     if (nboot(2) == 0)
-      nk(j) = sum (g == gk(j));
       if (strcmp (func2str (bootfun), 'mean'))
-        theta(j) = mean (data(g == gk(j), :));
+        theta(j) = mean (data(rows{j}, :));
         % Quick analytical calculation for the standard error of the mean
-        SE(j) = std (data(g == gk(j), :), 0) / sqrt (nk(j));
+        SE(j) = std (data(rows{j}, :), 0) / sqrt (nk(j));
         if (j == 1); se_method = 'Calculated without resampling'; end
       else
-        theta(j) = bootfun (data(g == gk(j), :));
+        theta(j) = bootfun (data(rows{j}, :));
         % If requested, compute unbiased estimates of the standard error using
         % jackknife resampling
-        jackstat = jackknife (bootfun, data(g == gk(j), :));
+        jackstat = jackknife (bootfun, data(rows{j}, :));
         SE(j) = sqrt ((nk(j) - 1) / nk(j) * ...
                 sum (((mean (jackstat) - jackstat)).^2));
         if (j == 1); se_method = 'Leave-one-out jackknife'; end
@@ -454,9 +484,8 @@ function [pval, c, stats, Q] = boot1way (data, group, varargin)
       % Compute unbiased estimate of the standard error by balanced bootknife
       % resampling. Bootknife resampling involves less computation than
       % Jackknife when sample sizes get larger
-      theta(j) = bootfun (data(g == gk(j), :));
-      nk(j) = sum (g == gk(j));
-      bootout = bootknife (data(g == gk(j), :), [nboot(2), 0], bootfun, ...
+      theta(j) = bootfun (data(rows{j}, :));
+      bootout = bootknife (data(rows{j}, :), [nboot(2), 0], bootfun, ...
                            NaN, [], 0, [], [], ISOCTAVE, false, true);
       SE(j) = bootout.std_error;
       if (j==1); se_method = 'Balanced, bootknife resampling'; end
@@ -688,37 +717,36 @@ end
 
 %--------------------------------------------------------------------------
 
-function maxT = maxstat (Y, g, nboot, bootfun, ref, ISOCTAVE)
+function maxT = maxstat (Y, rows, nboot, bootfun, ref, ISOCTAVE)
 
   % Helper function file required for boot1way
-  % Calculate maximum test statistic
+  % Calculate maximum test statistic. rows is a cell array containing the row
+  % indices of the data in each group
   
   % maxstat cannot be a subfunction or nested function since 
   % Octave parallel threads won't be able to find it
 
-  % Calculate the size of the data (N) and the number (k) of unique groups
-  N = size (g, 1);
-  gk = unique (g);
-  k = numel (gk);
+  % Calculate the size of the data (N) and the number (k) of groups
+  N = size (Y, 1);
+  k = numel (rows);
 
   % Compute the estimate (theta) and it's pooled (weighted mean) sampling
   % variance 
   theta = zeros (k, 1);
   SE = zeros (k, 1);
   Var = zeros (k, 1);
-  nk = zeros (size (gk));
+  nk = cellfun (@numel, rows);
   for j = 1:k
     if (nboot == 0)
-      nk(j) = sum (g == gk(j));
       if strcmp (func2str (bootfun), 'mean')
-        theta(j) = mean (Y(g == gk(j), :));
+        theta(j) = mean (Y(rows{j}, :));
         % Quick calculation for the standard error of the mean
-        SE(j) = std (Y(g == gk(j), :), 0) / sqrt (nk(j));
+        SE(j) = std (Y(rows{j}, :), 0) / sqrt (nk(j));
       else
-        theta(j) = bootfun (Y(g == gk(j), :));
+        theta(j) = bootfun (Y(rows{j}, :));
         % If requested, compute unbiased estimates of the standard error
         % using jackknife resampling
-        jackstat = jackknife (bootfun, Y(g == gk(j), :));
+        jackstat = jackknife (bootfun, Y(rows{j}, :));
         SE(j) = sqrt ((nk(j) - 1) / nk(j) ...
                 * sum (((mean (jackstat) - jackstat)).^2));
       end
@@ -726,9 +754,8 @@ function maxT = maxstat (Y, g, nboot, bootfun, ref, ISOCTAVE)
       % Compute unbiased estimate of the standard error by balanced bootknife
       % resampling. Bootknife resampling involves less computation than
       % Jackknife when sample sizes get larger
-      theta(j) = bootfun (Y(g == gk(j), :));
-      nk(j) = sum (g == gk(j));
-      bootout = bootknife (Y(g == gk(j), :), [nboot, 0], bootfun, ...
+      theta(j) = bootfun (Y(rows{j}, :));
+      bootout = bootknife (Y(rows{j}, :), [nboot, 0], bootfun, ...
                            NaN, [], 0, [], [], ISOCTAVE, false, true);
       SE(j) = bootout.std_error;
     end
@@ -769,6 +796,108 @@ end
 
 %--------------------------------------------------------------------------
 
+function maxT = vmaxstat (Y, ord, nk, nboot, bootfun, ref)
+
+  % Helper function file required for boot1way
+  % Calculate the maximum test statistic for each column of Y when bootfun is
+  % vectorized. The rows of Y are sorted by group (ord) so that the DATA for
+  % each group is a contiguous block of rows with nk(j) rows. The inner
+  % bootknife resamples are drawn in the same order as the calls that maxstat
+  % makes to bootknife for each column of Y in turn.
+
+  % Calculate the size of the data (N) and the number (k) of groups
+  [N, B] = size (Y);
+  k = numel (nk);
+  Y = Y(ord, :);
+  offset = cat (1, 0, cumsum (nk));
+  rows = arrayfun (@(j) offset(j) + 1 : offset(j + 1), 1 : k, ...
+                   'UniformOutput', false);
+
+  % Compute the estimates (theta) and their standard errors for each group 
+  theta = zeros (k, B);
+  SE = zeros (k, B);
+  for j = 1:k
+    theta(j, :) = bootfun (Y(rows{j}, :));
+  end
+  if (nboot == 0)
+    if strcmp (func2str (bootfun), 'mean')
+      % Quick calculation for the standard error of the mean
+      for j = 1:k
+        SE(j, :) = std (Y(rows{j}, :), 0, 1) / sqrt (nk(j));
+      end
+    else
+      % Compute unbiased estimates of the standard error using jackknife
+      % resampling
+      for j = 1:k
+        Yj = Y(rows{j}, :);
+        jackstat = zeros (nk(j), B);
+        for i = 1:nk(j)
+          jackstat(i, :) = bootfun (Yj((1 : nk(j)) ~= i, :));
+        end
+        SE(j, :) = sqrt ((nk(j) - 1) / nk(j) * ...
+                   sum (bsxfun (@minus, mean (jackstat, 1), jackstat).^2, 1));
+      end
+    end
+  else
+    % Compute unbiased estimates of the standard error by balanced bootknife
+    % resampling, in blocks of columns of Y to limit memory usage
+    blksz = max (1, fix (1e+07 / (N * nboot)));
+    for b = 1 : blksz : B
+      idx = b : min (b + blksz - 1, B);
+      nb = numel (idx);
+      X = arrayfun (@(j) zeros (nk(j), nboot * nb), 1 : k, ...
+                    'UniformOutput', false);
+      for i = 1:nb
+        for j = 1:k
+          X{j}(:, (i - 1) * nboot + (1 : nboot)) = boot (Y(rows{j}, idx(i)), ...
+                                                         nboot, true);
+        end
+      end
+      for j = 1:k
+        bootstat = reshape (bootfun (X{j}), nboot, nb);
+        % Omit bootstrap statistics that are NaN or Inf
+        ok = isfinite (bootstat);
+        nok = sum (ok, 1);
+        if (any (nok == 0))
+          error ('bootknife: BOOTFUN returned NaN for every bootstrap resample')
+        end
+        bootstat(~ ok) = 0;
+        D = bsxfun (@minus, bootstat, sum (bootstat, 1) ./ nok) .* ok;
+        SE(j, idx) = sqrt (sum (D.^2, 1) ./ max (nok - 1, 1));
+      end
+    end
+  end
+  if (any (isnan (SE(:))))
+    error (cat (2, 'boot1way:maxstat: Evaluating bootfun on the bootknife', ...
+                   ' resamples created NaN values for the standard error'))
+  end
+  Var = bsxfun (@times, (nk - 1) / (N - k), SE.^2);
+  nk_bar = sum (nk.^2) ./ sum (nk);                 % weighted mean sample size
+  Var = sum (bsxfun (@times, Var, nk / nk_bar), 1); % weighted pooled variance
+
+  % Calculate weights to correct for unequal sample size  
+  % when calculating standard error of the difference
+  w = nk_bar ./ nk;
+
+  % Calculate the maximum test statistic 
+  if (isempty (ref))
+    % Calculate Tukey-Kramer test statistic (without sqrt(2) factor)
+    idx = logical (triu (ones (k, k), 1));
+    i = (1 : k)' * ones (1, k);
+    j = ones (k, 1) * (1 : k);
+    t = abs (theta(i(idx), :) - theta(j(idx), :)) ./ ...
+        sqrt (bsxfun (@times, Var, w(i(idx)) + w(j(idx))));
+  else
+    % Calculate Dunnett's test statistic 
+    t = abs (bsxfun (@minus, theta, theta(ref, :))) ./ ...
+        sqrt (bsxfun (@times, Var, w + w(ref)));
+  end
+  maxT = max (t, [], 1);
+  
+end
+
+%--------------------------------------------------------------------------
+
 % FUNCTION TO COMPUTE MINIMUM FALSE POSITIVE RISK (FPR)
 
 function fpr = pval2fpr (p)
@@ -1036,3 +1165,31 @@ end
 %! func = @(M) subsref (M(:,2:end) \ M(:,1), ...
 %!                      struct ('type', '()', 'subs', {{2}}));
 %! p = boot1way ([y, X], g, 'bootfun', func, 'DisplayOpt', false);
+
+%!test
+%! % Test that the vectorized calculation of the maximum test statistic gives
+%! % the same result as maxstat, which is used when bootfun is not vectorized
+%! y = [54  87  45
+%!      23  98  39
+%!      45  64  51
+%!      54  77  49
+%!      45  89  50
+%!      47 NaN  55];
+%! g = [ 1   2   3
+%!       1   2   3
+%!       1   2   3
+%!       1   2   3
+%!       1   2   3
+%!       1   2   3];
+%! vfun = @(y) mean (y);      % vectorized (evaluated by vmaxstat)
+%! sfun = @(y) mean (y(:));   % not vectorized (evaluated by maxstat)
+%! if (isempty (regexp (which ('boot'), 'mex$')))
+%!   for nboot = [0, 49]
+%!     [p1, c1, stats1, Q1] = boot1way (y(:), g(:), 'bootfun', vfun, ...
+%!                                   'nboot', [199, nboot], 'DisplayOpt', false);
+%!     [p2, c2, stats2, Q2] = boot1way (y(:), g(:), 'bootfun', sfun, ...
+%!                                   'nboot', [199, nboot], 'DisplayOpt', false);
+%!     assert (Q1, Q2, -1e-09);
+%!     assert (p1, p2, 1e-09);
+%!   end
+%! end
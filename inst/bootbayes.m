@@ -57,6 +57,12 @@
 %     where NBOOT must be a positive integer. If empty, the default value of
 %     NBOOT is 1999.
 %
+%     'bootbayes (Y, X, ..., [NBOOT, TOL])' generates the bootstrap resamples
+%     in batches of 499 and stops once the Monte Carlo standard errors of the
+%     credible interval bounds, in units of the posterior standard deviation,
+%     all fall below the tolerance, TOL, or once NBOOT resamples have been
+%     generated. TOL must be a positive scalar less than 1.
+%
 %     'bootbayes (Y, X, ..., NBOOT, PROB)' where PROB is numeric and sets the
 %     lower and upper bounds of the credible interval(s). The value(s) of PROB
 %     must be between 0 and 1. PROB can either be:
@@ -247,6 +253,10 @@ function [stats, bootstat] = bootbayes (Y, X, dep, nboot, prob, prior, seed, ...
       N = numel (C); % Number of clusters
       method = 'cluster ';
     end
+    % Sparse matrix that sums the rows of a matrix within each cluster. The
+    % random draws for each cluster are never expanded to the n observations:
+    % sums over observations are instead obtained from the cluster sums.
+    M = sparse (IC, (1:n)', 1, N, n);
   else
     N = n;
     IC = [];
@@ -257,14 +267,22 @@ function [stats, bootstat] = bootbayes (Y, X, dep, nboot, prob, prior, seed, ...
   end
 
   % Evaluate number of bootstrap resamples
+  tol = 0;
   if ( (nargin < 4) || (isempty (nboot)) )
     nboot = 1999;
   else
     if (~ isa (nboot, 'numeric'))
       error ('bootbayes: NBOOT must be numeric')
     end
+    if (numel (nboot) > 2)
+      error ('bootbayes: NBOOT must be scalar or a pair [NBOOT, TOL]')
+    end
     if (numel (nboot) > 1)
-      error ('bootbayes: NBOOT must be scalar')
+      tol = nboot(2);
+      nboot = nboot(1);
+      if ((tol <= 0) || (tol >= 1))
+        error ('bootbayes: TOL must be between 0 and 1')
+      end
     end
     if (nboot ~= abs (fix (nboot)))
       error ('bootbayes: NBOOT must be a positive integer')
@@ -336,51 +354,106 @@ function [stats, bootstat] = bootbayes (Y, X, dep, nboot, prob, prior, seed, ...
     end
   end
 
-  % Create weights by randomly sampling from a symmetric Dirichlet distribution.
-  % This can be achieved by normalizing a set of randomly generated values from
-  % a Gamma distribution to their sum.
-  if (prior > 0)
-    if (ISOCTAVE)
-      r = randg (prior, N, nboot);
-    else
-      if ((exist ('gammaincinv', 'builtin')) || ...
-          (exist ('gammaincinv', 'file')))
-        r = gammaincinv (rand (N, nboot), prior); % Fast
-      else
-        % Earlier versions of Matlab do not have gammaincinv
-        % Instead, use functions from the Statistics and Machine Learning Toolbox
-        try 
-          r = gaminv (rand (N, nboot), prior, 1); % Fast
-        catch
-          r = gamrnd (prior, 1, N, nboot); % Slow 
-        end
-      end
-    end
-  else
-    % Haldane prior
-    warning (cat (2, 'bootbayes: PRIOR value has been set to 0 - the', ...
-                     ' posterior will contain relatively few unique values.'))
-    r = zeros (N, nboot);
-    idx = fix (rand (1, nboot) * N + (1:N:(nboot * N)));
-    r(idx)=1;
-  end
-  if (~ isempty (IC))
-    r = r(IC, :);  % Enforce clustering/blocking
-  end
-  W = bsxfun (@rdivide, r, sum (r));
-
-  % Compute bootstap statistics
+  % Generate the bootstrap statistics. In adaptive mode (TOL > 0), the
+  % resamples are generated and evaluated in batches until the Monte Carlo
+  % error of the credible intervals is within tolerance.
   if (intercept_only)
-    bootfun = @(Y) sum (bsxfun (@times, Y, W));  % Faster!
     original = mean (Y, 1)';
-    bootstat = cell2mat (cellfun (bootfun, num2cell (Y, 1)', ...
-                                 'UniformOutput', false));
   else
     bootfun = @(w) lmfit (X, Y, w, L);
     original = bootfun (ones (n, 1) / n);
-    bootstat = cell2mat (cellfun (bootfun, num2cell (sqrt (W), 1), ...
-                                  'UniformOutput', false));
   end
+  if (tol > 0)
+    batchsz = 499;
+  else
+    batchsz = nboot;
+  end
+  bootstat = zeros (p, 0);
+  B = 0;
+  while (B < nboot)
+    nb = min (batchsz, nboot - B);
+
+    % Create weights by randomly sampling from a symmetric Dirichlet
+    % distribution. This can be achieved by normalizing a set of randomly
+    % generated values from a Gamma distribution to their sum.
+    if (prior > 0)
+      if (ISOCTAVE)
+        r = randg (prior, N, nb);
+      else
+        if ((exist ('gammaincinv', 'builtin')) || ...
+            (exist ('gammaincinv', 'file')))
+          r = gammaincinv (rand (N, nb), prior); % Fast
+        else
+          % Earlier versions of Matlab do not have gammaincinv
+          % Instead, use functions from the Statistics and Machine Learning
+          % Toolbox
+          try 
+            r = gaminv (rand (N, nb), prior, 1); % Fast
+          catch
+            r = gamrnd (prior, 1, N, nb); % Slow 
+          end
+        end
+      end
+    else
+      % Haldane prior
+      if (B == 0)
+        warning (cat (2, 'bootbayes: PRIOR value has been set to 0 - the', ...
+                         ' posterior will contain relatively few unique values.'))
+      end
+      r = zeros (N, nb);
+      idx = fix (rand (1, nb) * N + (1:N:(nb * N)));
+      r(idx)=1;
+    end
+
+    % Compute bootstap statistics. Each observation has the weight of its
+    % cluster (i.e. the weights are r(IC, :) normalized to sum to 1 for each
+    % resample).
+    if (intercept_only)
+      % The weighted means are computed from the sums of Y within each cluster
+      % and the cluster sizes
+      if (isempty (IC))
+        bootstat(:, B + (1:nb)) = bsxfun (@rdivide, Y' * r, sum (r, 1));
+      else
+        bootstat(:, B + (1:nb)) = bsxfun (@rdivide, (M * Y)' * r, ...
+                                          full (sum (M, 2))' * r);
+      end
+    else
+      % The weights are expanded to the observations one resample at a time
+      bootstat(:, B + (1:nb)) = 0;
+      for b = 1:nb
+        if (isempty (IC))
+          w = r(:, b);
+        else
+          w = r(IC, b);  % Enforce clustering/blocking
+        end
+        bootstat(:, B + b) = bootfun (sqrt (w / sum (w)));
+      end
+    end
+    B = B + nb;
+
+    % Stopping rule for adaptive mode
+    if ((tol > 0) && (B < nboot))
+      sd = std (bootstat, 1, 2);
+      if (any (~ isnan (prob)))
+        if (prior > 0)
+          ci = credint (bootstat, prob);
+        else
+          % The error of normal intervals is that of the standard deviation
+          ci = bsxfun (@plus, mean (bootstat, 2), sd * [-1, 1]);
+        end
+        mcse = cat (2, ...
+               quantse (bootstat, mean (bsxfun (@le, bootstat, ci(:, 1)), 2)), ...
+               quantse (bootstat, mean (bsxfun (@le, bootstat, ci(:, 2)), 2)));
+        mcse = bsxfun (@rdivide, mcse, sd);
+      else
+        mcse = 1 / sqrt (B);
+      end
+      if (all (mcse(:) <= tol))
+        break
+      end
+    end
+  end
+  nboot = B;
 
   % Bootstrap bias estimation
   bias = mean (bootstat, 2) - original;
@@ -547,6 +620,12 @@ end
 %! stats = bootbayes(heights,[],2);
 %! stats = bootbayes(heights,[],[1;1;1;1;2;2;2;3;3;3]);
 %! stats = bootbayes(heights,[],[],1999);
+%! % Adaptive NBOOT stops after the first batch of 499 resamples when the
+%! % tolerance is easily met, and runs to NBOOT when it cannot be met
+%! [stats,bootstat] = bootbayes(heights,[],[],[19999,0.5]);
+%! assert (size (bootstat, 2), 499);
+%! [stats,bootstat] = bootbayes(heights,[],[],[1999,1e-06]);
+%! assert (size (bootstat, 2), 1999);
 %! stats = bootbayes(heights,[],[],[],0.05);
 %! stats = bootbayes(heights,[],[],[],[0.025,0.975]);
 %! stats = bootbayes(heights,[],[],[],[]);
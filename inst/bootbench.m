@@ -0,0 +1,325 @@
+% Benchmarks the functions and compiled (MEX) kernels of this package
+%
+% -- Function File: bootbench
+% -- Function File: bootbench (FILENAME)
+% -- Function File: bootbench (FILENAME, QUICK)
+% -- Function File: RESULTS = bootbench (...)
+%
+%     'bootbench' times the resampling functions of this package over grids of
+%     problem sizes and prints a table of the results. The following cases are
+%     benchmarked:
+%        o boot: N x NBOOT x LOO x uniform or non-uniform WEIGHTS
+%        o smoothmedian: column length x number of columns x DIM x NCPUS
+%        o bootknife: N x single or double (i.e. iterated) bootstrap
+%        o bootwild and bootbayes: N x number of predictors x no clusters or
+%          clusters of size 10
+%        o randtest2: N x unpaired or paired samples
+%     Each case is timed over 3 repetitions (after a warm-up run) and the
+%     median time is reported, together with the throughput (in resamples,
+%     columns or permutations per second) and the increase in peak memory
+%     (resident set size, in MB) during the case. Peak memory can only be
+%     measured on Linux and is NaN elsewhere. The scaling of smoothmedian with
+%     the number of threads is measured by setting NCPUS to 1, 2, 4, ..., up to
+%     the number of cores on the machine.
+%
+%     'bootbench (FILENAME)' also appends the results to the comma-separated
+%     values (CSV) file FILENAME, which is created with a header line if it does
+%     not already exist. Each line records the package version, the program
+%     (Octave or Matlab) and its version, the architecture, whether the boot
+%     and smoothmedian MEX files were used, the date and the results of one
+%     case, so that results from different releases and machines can be
+%     collected in the same file and compared to track regressions.
+%
+%     'bootbench (FILENAME, QUICK)' runs a reduced grid with 1 repetition per
+%     case if QUICK is true, which is useful to check that the benchmarks run.
+%     The default value of QUICK is false. If FILENAME is empty, no file is
+%     written.
+%
+%     'RESULTS = bootbench (...)' returns the results as a structure array
+%     with one element per case and the same fields as the columns of the CSV
+%     file.
+%
+%  bootbench (version 2026.10.17)
+%  Author: Andrew Charles Penn
+%  https://www.researchgate.net/profile/Andrew_Penn/
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function results = bootbench (filename, quick)
+
+  % Check input arguments
+  if ((nargin < 1) || isempty (filename))
+    filename = [];
+  elseif (~ ischar (filename))
+    error ('bootbench: FILENAME must be a character array')
+  end
+  if ((nargin < 2) || isempty (quick))
+    quick = false;
+  end
+
+  % Check if running in Octave (else assume Matlab)
+  info = ver;
+  ISOCTAVE = any (ismember ({info.Name}, 'Octave'));
+  if (ISOCTAVE)
+    program = sprintf ('Octave %s', version);
+    ncpus = nproc;
+  else
+    program = sprintf ('Matlab %s', version);
+    ncpus = feature ('numcores');
+  end
+
+  % Describe the environment
+  env = struct;
+  env.version = pkgversion ();
+  env.program = program;
+  env.arch = computer;
+  env.mex = sprintf ('boot:%d smoothmedian:%d', ...
+                     ~ isempty (regexp (which ('boot'), 'mex$')), ...
+                     ~ isempty (regexp (which ('smoothmedian'), 'mex$')));
+  env.date = datestr (now, 'yyyy-mm-dd HH:MM:SS');
+
+  % Set the grids of problem sizes
+  if (quick)
+    nreps = 1;
+    boot_n = [10, 100];
+    boot_nboot = 200;
+    sm_m = [10, 100];
+    sm_n = 100;
+    knife_n = [20, 200];
+    knife_nboot = {199, [199, 19]};
+    lm_n = [50, 500];
+    lm_p = [2, 10];
+    rt_n = [20, 200];
+  else
+    nreps = 3;
+    boot_n = [10, 100, 1000];
+    boot_nboot = [200, 2000];
+    sm_m = [10, 100, 1000];
+    sm_n = [100, 1000];
+    knife_n = [20, 200, 2000];
+    knife_nboot = {1999, [1999, 199]};
+    lm_n = [50, 500, 5000];
+    lm_p = [2, 10];
+    rt_n = [20, 200, 2000];
+  end
+  threads = unique ([2 .^ (0 : floor (log2 (ncpus))), ncpus]);
+
+  % Generate data reproducibly
+  rand ('state', 1);
+  randn ('state', 1);
+
+  % Run the benchmarks
+  results = [];
+  fprintf ('\n%-12s %-40s %8s %12s %14s %10s\n', 'Function', 'Problem', ...
+           'Threads', 'Time (s)', 'Throughput', 'Peak (MB)');
+
+  % boot
+  for n = boot_n
+    for nboot = boot_nboot
+      for loo = [false, true]
+        for w = 1:2
+          if (w == 1)
+            weights = [];
+            label = 'uniform';
+          else
+            weights = ones (n, 1) * nboot;
+            weights(1:2:end - 1) = weights(1:2:end - 1) - fix (nboot / 2);
+            weights(2:2:end) = weights(2:2:end) + fix (nboot / 2);
+            label = 'weighted';
+          end
+          results = record (results, env, 'boot', ...
+                    sprintf ('n=%d nboot=%d loo=%d %s', n, nboot, loo, label), ...
+                    n, nboot, 1, nboot, 'resamples/s', nreps, ...
+                    @() boot (n, nboot, loo, 1, weights));
+        end
+      end
+    end
+  end
+
+  % smoothmedian
+  for m = sm_m
+    for n = sm_n
+      x = randn (m, n);
+      xt = x.';
+      for dim = 1:2
+        for nthreads = threads
+          if (dim == 1)
+            f = @() smoothmedian (x, 1, [], nthreads);
+          else
+            f = @() smoothmedian (xt, 2, [], nthreads);
+          end
+          results = record (results, env, 'smoothmedian', ...
+                    sprintf ('m=%d n=%d dim=%d', m, n, dim), ...
+                    m, n, nthreads, n, 'columns/s', nreps, f);
+        end
+      end
+    end
+  end
+
+  % bootknife
+  for n = knife_n
+    y = randn (n, 1);
+    for i = 1:numel (knife_nboot)
+      nboot = knife_nboot{i};
+      if (numel (nboot) > 1)
+        label = 'double';
+        total = nboot(1) * (nboot(2) + 1);
+      else
+        label = 'single';
+        total = nboot;
+      end
+      results = record (results, env, 'bootknife', ...
+                sprintf ('n=%d nboot=%s %s', n, mat2str (nboot), label), ...
+                n, total, 1, total, 'resamples/s', nreps, ...
+                @() bootknife (y, nboot, @mean, [], [], 0, [], [], ISOCTAVE));
+    end
+  end
+
+  % bootwild and bootbayes
+  nboot = 1999;
+  for n = lm_n
+    for p = lm_p
+      X = cat (2, ones (n, 1), randn (n, p - 1));
+      y = X * ones (p, 1) + randn (n, 1);
+      for clusters = [false, true]
+        if (clusters)
+          clustid = ceil ((1 : n)' / 10);
+          label = 'clusters of 10';
+        else
+          clustid = [];
+          label = 'no clusters';
+        end
+        casename = sprintf ('n=%d p=%d %s', n, p, label);
+        results = record (results, env, 'bootwild', casename, n, nboot, 1, ...
+                  nboot, 'resamples/s', nreps, ...
+                  @() bootwild (y, X, clustid, nboot, 0.05, 1, [], ISOCTAVE));
+        results = record (results, env, 'bootbayes', casename, n, nboot, 1, ...
+                  nboot, 'resamples/s', nreps, ...
+                  @() bootbayes (y, X, clustid, nboot, 0.95, 1, 1, [], ISOCTAVE));
+      end
+    end
+  end
+
+  % randtest2
+  nperm = 5000;
+  for n = rt_n
+    A = randn (n, 1);
+    B = randn (n, 1) + 0.5;
+    for paired = [false, true]
+      results = record (results, env, 'randtest2', ...
+                sprintf ('n=%d paired=%d', n, paired), n, nperm, 1, nperm, ...
+                'permutations/s', nreps, ...
+                @() randtest2 (A, B, paired, nperm, [], 1));
+    end
+  end
+
+  % Write the results to file
+  if (~ isempty (filename))
+    writeresults (filename, results);
+    fprintf ('\nResults appended to %s\n', filename);
+  end
+
+  if (nargout < 1)
+    clear results
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function results = record (results, env, func, casename, n, nboot, ...
+                           nthreads, work, units, nreps, f)
+
+  % Helper subfunction to time a benchmark case and append the result
+  out = f ();             % Warm up
+  t = zeros (nreps, 1);
+  rss0 = resetpeak ();
+  for i = 1:nreps
+    t0 = tic;
+    out = f ();
+    t(i) = toc (t0);
+  end
+  peak = (procstatus ('VmHWM') - rss0) / 1024;
+  t = median (t);
+  result = env;
+  result.function = func;
+  result.problem = casename;
+  result.n = n;
+  result.nboot = nboot;
+  result.threads = nthreads;
+  result.time = t;
+  result.throughput = work / t;
+  result.units = units;
+  result.peak_mb = max (peak, 0);
+  fprintf ('%-12s %-40s %8d %12.4g %14.4g %10.1f\n', func, casename, ...
+           nthreads, t, work / t, result.peak_mb);
+  results = cat (1, results, result);
+
+end
+
+%--------------------------------------------------------------------------
+
+function v = pkgversion ()
+
+  % Helper subfunction to read the package version from the DESCRIPTION file
+  % (in the source tree, or in the packinfo directory of an installed package)
+  v = 'unknown';
+  d = fileparts (mfilename ('fullpath'));
+  fid = fopen (fullfile (d, '..', 'DESCRIPTION'), 'r');
+  if (fid < 0)
+    fid = fopen (fullfile (d, 'packinfo', 'DESCRIPTION'), 'r');
+  end
+  if (fid < 0)
+    return
+  end
+  str = fread (fid, Inf, 'char=>char')';
+  fclose (fid);
+  tok = regexp (str, 'version:\s*(\S+)', 'tokens', 'once');
+  if (~ isempty (tok))
+    v = tok{1};
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function writeresults (filename, results)
+
+  % Helper subfunction to append the results to a CSV file
+  fields = fieldnames (results);
+  isnew = ~ exist (filename, 'file');
+  fid = fopen (filename, 'a');
+  if (fid < 0)
+    error ('bootbench: Could not open %s for writing', filename)
+  end
+  if (isnew)
+    fprintf (fid, '%s\n', strjoin (fields', ','));
+  end
+  for i = 1:numel (results)
+    vals = cell (1, numel (fields));
+    for j = 1:numel (fields)
+      val = results(i).(fields{j});
+      if (ischar (val))
+        vals{j} = cat (2, '"', strrep (val, '"', '""'), '"');
+      else
+        vals{j} = sprintf ('%.6g', val);
+      end
+    end
+    fprintf (fid, '%s\n', strjoin (vals, ','));
+  end
+  fclose (fid);
+
+end
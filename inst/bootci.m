@@ -7,7 +7,9 @@
 % -- Function File: CI = bootci (NBOOT, {BOOTFUN, D1, ..., DN}, NAME, VALUE)
 % -- Function File: CI = bootci (...,'type', TYPE)
 % -- Function File: CI = bootci (...,'type', 'stud', 'nbootstd', NBOOTSTD)
+% -- Function File: CI = bootci (...,'type', 'stud', 'stderr', STDERR)
 % -- Function File: CI = bootci (...,'type', 'cal', 'nbootcal', NBOOTCAL)
+% -- Function File: CI = bootci (...,'type', 'cal', 'checkpoint', FILENAME)
 % -- Function File: CI = bootci (...,'alpha', ALPHA)
 % -- Function File: CI = bootci (...,'strata', STRATA)
 % -- Function File: CI = bootci (...,'loo', LOO)
@@ -21,7 +23,10 @@
 %     handle (e.g. specified with @), or a string indicating the function name. 
 %     The third input argument, data D (a column vector or a matrix), is used
 %     as input for BOOTFUN. The bootstrap resampling method yields first-order
-%     balance [2-3].
+%     balance [2-3]. For the 'norm', 'per', 'basic' and 'bca' interval types,
+%     NBOOT can also be a pair [NBOOT, TOL], where TOL is between 0 and 1, to
+%     draw the resamples in batches of 499 until the Monte Carlo error of the
+%     intervals falls below TOL (see bootknife), or NBOOT resamples are drawn.
 %
 %     'CI = bootci (NBOOT, BOOTFUN, D1,...,DN)' is as above except that the
 %     third and subsequent numeric input arguments are data (column vectors
@@ -65,12 +70,32 @@
 %     of resamples. Standard errors are computed using NBOOTSTD bootstrap
 %     resamples. The default value of NBOOTSTD is 100.
 %
+%     'CI = bootci (..., 'type', 'stud', 'stderr', STDERR)' sets the method
+%     used to estimate the standard errors of the bootstrap statistics for the
+%     Studentized bootstrap confidence intervals. STDERR can be 'boot' to use
+%     NBOOTSTD bootstrap resamples of each bootstrap sample (default), or
+%     'jack' to use the jackknife. The jackknife requires only n evaluations of
+%     BOOTFUN per bootstrap sample, and for the mean and variance of univariate
+%     data the jackknife statistics are computed directly in O(n) operations.
+%
 %     'CI = bootci (..., 'type', 'cal', 'nbootcal', NBOOTCAL)' computes the
 %     calibrated percentile bootstrap confidence intervals CI, with the
 %     calibrated percentiles of the bootstrap statistics estimated from NBOOTCAL
 %     bootstrap data samples. NBOOTCAL is a positive integer value. The default
 %     value of NBOOTCAL is 199.
 %
+%     'CI = bootci (..., 'type', 'cal', 'checkpoint', FILENAME)' periodically
+%     saves the progress of the (double) bootstrap to a MAT-file, FILENAME.
+%     If the computations are interrupted, calling bootci again with the same
+%     arguments resumes them from the last checkpoint in FILENAME. The file is
+%     deleted once the computations are complete. The inner bootstrap
+%     resamples are drawn using seeds derived from a base seed saved in
+%     FILENAME, so that a resumed run gives exactly the same intervals as an
+%     uninterrupted run, but these differ (by Monte Carlo error) from the
+%     intervals computed for the same SEED without checkpointing. An error is
+%     raised if FILENAME is the checkpoint of a different DATA, NBOOT or
+%     BOOTFUN.
+%
 %     'CI = bootci (..., 'strata', STRATA)' sets STRATA, which are identifiers
 %     that define the grouping of the DATA rows for stratified bootstrap
 %     resampling. STRATA should be a column vector or cell array with the same
@@ -166,7 +191,9 @@ function [ci, bootstat, bootsam] = bootci (argin1, argin2, varargin)
   alpha = 0.05;
   type = 'bca';
   nbootstd = 100;
+  stderr = 'boot';
   nbootcal = 199;
+  checkpoint = '';
   strata = [];
   loo = false;
   paropt = struct;
@@ -195,8 +222,12 @@ function [ci, bootstat, bootsam] = bootci (argin1, argin2, varargin)
           type = value;
         case 'nbootstd'
           nbootstd = value;
+        case 'stderr'
+          stderr = value;
         case 'nbootcal'
           nbootcal = value;
+        case 'checkpoint'
+          checkpoint = value;
         case 'strata'
           strata = value;
         case 'loo'
@@ -263,10 +294,19 @@ function [ci, bootstat, bootsam] = bootci (argin1, argin2, varargin)
   if (~ isa (nboot, 'numeric'))
     error ('bootci: NBOOT must be numeric');
   end
-  if (numel (nboot) > 1)
+  if (numel (nboot) > 2)
     error ('bootci: NBOOT must be a positive integer');
   end
-  if (nboot ~= abs (fix (nboot)))
+  if (numel (nboot) > 1)
+    if ((nboot(2) <= 0) || (nboot(2) >= 1))
+      error ('bootci: TOL must be between 0 and 1');
+    end
+    if (ismember (lower (type), {'stud', 'student', 'cal'}))
+      error (cat (2, 'bootci: NBOOT must be a positive integer for', ...
+                     ' studentized and calibrated intervals'));
+    end
+  end
+  if (nboot(1) ~= abs (fix (nboot(1))))
     error ('bootci: NBOOT must contain positive integers');
   end
   if (~ isa (nbootstd, 'numeric'))
@@ -278,6 +318,10 @@ function [ci, bootstat, bootsam] = bootci (argin1, argin2, varargin)
   if (nbootstd < 1)
     error ('bootci: NBOOTSTD must be an integer > 0');
   end  
+  if (~ ischar (stderr) || ~ ismember (lower (stderr), ...
+                                        {'boot', 'jack', 'jackknife'}))
+    error ('bootci: STDERR must be ''boot'' or ''jack''');
+  end
   if (~ isa (nbootcal, 'numeric'))
     error ('bootci: NBOOTCAL must be numeric');
   end
@@ -287,6 +331,9 @@ function [ci, bootstat, bootsam] = bootci (argin1, argin2, varargin)
   if (nbootcal ~= abs (fix (nbootcal)))
     error ('bootci: NBOOTCAL must be a positive integer');
   end
+  if (~ ischar (checkpoint))
+    error ('bootci: CHECKPOINT must be a file name');
+  end
   % If applicable, check we have parallel computing capabilities
   if (ncpus > 1)
     if (ISOCTAVE)
@@ -367,41 +414,46 @@ function [ci, bootstat, bootsam] = bootci (argin1, argin2, varargin)
       [stats, bootstat, bootsam] = bootknife (data, nboot, bootfun, NaN, ...
                                    strata, ncpus, [], [], ISOCTAVE, true, loo);
       % Automatically estimate standard errors of the bootstrap statistics
-      % Using bootstrap resampling
-      if (iscell (data))
-        % If DATA is a cell array of equal size colunmn vectors, convert the
-        % cell array to a matrix and define function to calculate an estimate
-        % of the standard error using bootstrap resampling
-        szx = cellfun (@(x) size (x, 2), data);
-        data = [data{:}];
-        cellfunc = @(bootsam) bootknife ( ...
+      if (ismember (lower (stderr), {'jack', 'jackknife'}))
+        % Using the jackknife
+        se = jackse (data, bootsam, bootfun, strata, size (bootstat, 1));
+      else
+        % Using bootstrap resampling
+        if (iscell (data))
+          % If DATA is a cell array of equal size colunmn vectors, convert the
+          % cell array to a matrix and define function to calculate an estimate
+          % of the standard error using bootstrap resampling
+          szx = cellfun (@(x) size (x, 2), data);
+          data = [data{:}];
+          cellfunc = @(bootsam) bootknife ( ...
                           mat2cell (data (bootsam,:), n, szx), nbootstd, ...
                           bootfun, NaN, strata, 0, [], [], ISOCTAVE, true, loo);
-      else
-        cellfunc = @(bootsam) bootknife (data (bootsam,:), nbootstd, ...
+        else
+          cellfunc = @(bootsam) bootknife (data (bootsam,:), nbootstd, ...
                           bootfun, NaN, strata, 0, [], [], ISOCTAVE, true, loo);
-      end
-      if (ncpus > 1)
-        if (ISOCTAVE)
-          % Octave
-          % Set unique random seed for each parallel thread
-          pararrayfun (ncpus, @boot, 1, 1, false, 1:ncpus);
-          bootout = parcellfun (ncpus, cellfunc, num2cell (bootsam, 1), ...
-                                'UniformOutput', false);
+        end
+        if (ncpus > 1)
+          if (ISOCTAVE)
+            % Octave
+            % Set unique random seed for each parallel thread
+            pararrayfun (ncpus, @boot, 1, 1, false, 1:ncpus);
+            bootout = parcellfun (ncpus, cellfunc, num2cell (bootsam, 1), ...
+                                  'UniformOutput', false);
+          else
+            % MATLAB
+            % Set unique random seed for each parallel thread
+            parfor i = 1:ncpus; boot (1, 1, false, i); end
+            % Perform inner layer of resampling
+            bootout = cell (1, nboot(1));
+            parfor b = 1:nboot(1); bootout{b} = cellfunc (bootsam(:,b)); end
+          end
         else
-          % MATLAB
-          % Set unique random seed for each parallel thread
-          parfor i = 1:ncpus; boot (1, 1, false, i); end
-          % Perform inner layer of resampling
-          bootout = cell (1, nboot(1));
-          parfor b = 1:nboot(1); bootout{b} = cellfunc (bootsam(:,b)); end
+          bootout = cellfun (cellfunc, num2cell (bootsam, 1), ...
+                             'UniformOutput', false);
         end
-      else
-        bootout = cellfun (cellfunc, num2cell (bootsam, 1), ...
-                           'UniformOutput', false);
+        se = cell2mat (cellfun (@(S) S.std_error, bootout, ...
+                                'UniformOutput', false));
       end
-      se = cell2mat (cellfun (@(S) S.std_error, bootout, ...
-                              'UniformOutput', false));
       % Compute additive constant to stabilize the variance
       a = n^(-3/2) * stats.std_error;
       % Calculate Studentized bootstrap statistics
@@ -425,7 +477,7 @@ function [ci, bootstat, bootsam] = bootci (argin1, argin2, varargin)
       % Use undocumented input argument 'loo' = false for simple bootstrap
       % resampling (instead of bootknife resampling)
       [stats, bootstat, bootsam] = bootknife (data, nboot, bootfun, alpha, ...
-                                    strata, ncpus, [], [], ISOCTAVE, true, loo);
+                        strata, ncpus, [], [], ISOCTAVE, true, loo, checkpoint);
 
   end
 
@@ -439,6 +491,201 @@ end
 
 %--------------------------------------------------------------------------
 
+function se = jackse (data, bootsam, bootfun, strata, m)
+
+  % Usage: se = jackse (data, bootsam, bootfun, strata, m)
+  % Jackknife estimates of the standard errors of the m statistics returned by
+  % bootfun, for each of the bootstrap samples of data in the columns of
+  % bootsam. For the mean and variance (of each column of the data), Pearson's
+  % correlation coefficient (cor) and the coefficients of a linear regression
+  % (mldivide), the leave-one-out statistics of all of the bootstrap samples
+  % are computed directly by O(n) downdates of the sample sums (or, for
+  % regression, of the least squares fit). Otherwise, bootfun is evaluated on
+  % the leave-one-out samples, in blocks of them if bootfun is vectorized.
+
+  % Convert bootfun to a function handle and extract any additional arguments
+  args = {};
+  if (iscell (bootfun))
+    args = bootfun(2:end);
+    bootfun = bootfun{1};
+  end
+  if (ischar (bootfun))
+    bootfun_str = bootfun;
+    bootfun = str2func (bootfun);
+  else
+    bootfun_str = func2str (bootfun);
+  end
+  if (iscell (data))
+    % If DATA is a cell array of equal size column vectors, convert the cell
+    % array to a matrix and pass the blocks of columns as separate arguments
+    szx = cellfun (@(x) size (x, 2), data);
+    data = [data{:}];
+    func = @(x) feval (@(xcell) bootfun (xcell{:}, args{:}), ...
+                       mat2cell (x, size (x, 1), szx));
+  else
+    szx = size (data, 2);
+    func = @(x) bootfun (x, args{:});
+  end
+  [n, nvar] = size (data);
+  B = size (bootsam, 2);
+
+  % Sort the rows by stratum once, so that the leave-one-out statistics of the
+  % observations in each stratum are a contiguous block of ord with nk rows
+  if (isempty (strata))
+    ord = (1 : n)';
+    nk = n;
+  else
+    if (~ isnumeric (strata))
+      [jnk1, jnk2, strata] = unique (strata);
+      clear jnk1 jnk2;
+    end
+    [jnk, jnk, sidx] = unique (strata);
+    [jnk, ord] = sort (sidx(:));
+    clear jnk;
+    nk = accumarray (sidx(:), 1);
+  end
+
+  % Choose how to compute the leave-one-out statistics
+  opt = [args, {0}];
+  opt = opt{1};
+  if (isempty (opt))
+    opt = 0;
+  end
+  if (strcmp (bootfun_str, 'mean') && isempty (args) && (numel (szx) == 1))
+    method = 'mean';
+  elseif (strcmp (bootfun_str, 'var') && (n > 2) && (numel (args) < 2) && ...
+          (isequal (opt, 0) || isequal (opt, 1)) && (numel (szx) == 1))
+    method = 'var';
+  elseif (strcmp (bootfun_str, 'cor') && isempty (args) && (n > 2) && ...
+          isequal (szx, [1, 1]))
+    method = 'cor';
+  elseif (strcmp (bootfun_str, 'mldivide') && isempty (args) && ...
+          (numel (szx) == 2) && (szx(2) == 1) && (n > szx(1)))
+    method = 'mldivide';
+  elseif ((nvar > 1) || (numel (szx) > 1))
+    method = 'loop';
+  else
+    % Check whether bootfun is vectorized
+    try
+      chk = func (repmat (data, 1, 2));
+      if (isequal (chk, repmat (func (data), 1, 2)) && (size (chk, 1) == m))
+        method = 'vectorized';
+      else
+        method = 'loop';
+      end
+    catch
+      method = 'loop';
+    end
+  end
+
+  % Compute the jackknife standard errors. For the downdates, the bootstrap
+  % samples are evaluated in blocks (of columns of bootsam) to limit memory
+  % usage. Each leave-one-out statistic is computed from the deviations (d)
+  % of the observations from the mean of their bootstrap sample.
+  se = zeros (m, B);
+  switch (method)
+    case {'mean', 'var'}
+      blksz = max (1, fix (1e+07 / n));
+      for b = 1 : blksz : B
+        idx = b : min (b + blksz - 1, B);
+        for j = 1 : nvar
+          x = reshape (data(bootsam(:, idx), j), n, numel (idx));
+          if (strcmp (method, 'mean'))
+            T = bsxfun (@minus, sum (x, 1), x) / (n - 1);
+          else
+            d = bsxfun (@minus, x, mean (x, 1));
+            T = max (bsxfun (@minus, sum (d.^2, 1), d.^2 * n / (n - 1)), 0) ...
+                / (n - 2 + opt);
+          end
+          se(j, idx) = sqrt (jackvar (T(ord, :), nk));
+        end
+      end
+    case 'cor'
+      blksz = max (1, fix (1e+07 / n));
+      for b = 1 : blksz : B
+        idx = b : min (b + blksz - 1, B);
+        x = reshape (data(bootsam(:, idx), 1), n, numel (idx));
+        y = reshape (data(bootsam(:, idx), 2), n, numel (idx));
+        dx = bsxfun (@minus, x, mean (x, 1));
+        dy = bsxfun (@minus, y, mean (y, 1));
+        sxy = bsxfun (@minus, sum (dx .* dy, 1), dx .* dy * n / (n - 1));
+        sxx = bsxfun (@minus, sum (dx.^2, 1), dx.^2 * n / (n - 1));
+        syy = bsxfun (@minus, sum (dy.^2, 1), dy.^2 * n / (n - 1));
+        T = sxy ./ sqrt (sxx .* syy);
+        se(1, idx) = sqrt (jackvar (T(ord, :), nk));
+      end
+    case 'mldivide'
+      % The coefficients of the least squares fit without observation i are
+      % b - (X' * X) \ X(i, :)' * r(i) / (1 - h(i)), where r are the residuals
+      % and h the leverages of the fit to all of the observations
+      p = szx(1);
+      for b = 1 : B
+        X = data(bootsam(:, b), 1 : p);
+        y = data(bootsam(:, b), p + 1);
+        [Q, R] = qr (X, 0);
+        h = sum (Q.^2, 2);
+        if ((min (abs (diag (R))) > n * eps (norm (R, 1))) && ...
+            (all (h < 1 - 1e-08)))
+          coef = R \ (Q' * y);
+          r = y - X * coef;
+          T = bsxfun (@minus, coef', bsxfun (@times, Q / R', r ./ (1 - h)));
+        else
+          % Rank deficient fit or an observation with a leverage of 1
+          xb = [X, y];
+          T = zeros (n, m);
+          for i = 1 : n
+            T(i, :) = reshape (func (xb((1 : n) ~= i, :)), 1, []);
+          end
+        end
+        se(:, b) = sqrt (jackvar (T(ord, :), nk)).';
+      end
+    otherwise
+      T = zeros (m, n);
+      for b = 1 : B
+        x = data(bootsam(:, b), :);
+        switch (method)
+          case 'vectorized'
+            % Evaluate bootfun on blocks of the leave-one-out samples, whose
+            % sample indices are built for one block of columns at a time
+            blksz = max (1, fix (1e+07 / (n - 1)));
+            for i = 1 : blksz : n
+              idx = i : min (i + blksz - 1, n);
+              Jb = bsxfun (@plus, (1 : n - 1)', ...
+                           bsxfun (@ge, (1 : n - 1)', idx));
+              T(:, idx) = func (x(Jb));
+            end
+          case 'loop'
+            for i = 1 : n
+              T(:, i) = reshape (func (x((1 : n) ~= i, :)), [], 1);
+            end
+        end
+        se(:, b) = sqrt (jackvar (T(:, ord).', nk)).';
+      end
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function V = jackvar (T, nk)
+
+  % Usage: V = jackvar (T, nk)
+  % Stratified jackknife estimate of the variance of the statistics in each
+  % column of T, whose rows are the leave-one-out statistics sorted by stratum
+  % (in contiguous blocks of nk rows)
+  V = zeros (1, size (T, 2));
+  offset = 0;
+  for k = 1 : numel (nk)
+    Tk = T(offset + (1 : nk(k)), :);
+    V = V + (nk(k) - 1) / nk(k) * ...
+            sum (bsxfun (@minus, Tk, mean (Tk, 1)).^2, 1);
+    offset = offset + nk(k);
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
 %!demo
 %!
 %! % Input univariate dataset
@@ -790,6 +1037,8 @@ end
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'bca');
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'stud');
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'stud', 'nbootstd', 100);
+%!   bootci (1999, {@mean, y}, 'type', 'stud', 'stderr', 'jack');
+%!   bootci (1999, {{@var, 1}, y}, 'type', 'stud', 'stderr', 'jack');
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'cal');
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'cal', 'nbootcal', 199);
 %!   g = reshape (repmat ([1:5], 4, 1), 20, []);
@@ -799,6 +1048,7 @@ end
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'basic', 'strata', g);
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'bca', 'strata', g);
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'stud', 'strata', g);
+%!   bootci (1999, {@mean, y}, 'type', 'stud', 'stderr', 'jack', 'strata', g);
 %!   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'cal', 'strata', g);
 %!   Y = randn (20); 
 %!   bootci (1999, 'mean', Y);
@@ -825,6 +1075,7 @@ end
 %!   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'basic');
 %!   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'bca');
 %!   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'stud');
+%!   bootci (1999, {@mldivide, X, y}, 'type', 'stud', 'stderr', 'jack');
 %!   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'cal');
 %! catch
 %!   warning ('on', 'bootknife:parallel')
@@ -914,3 +1165,50 @@ end
 %!   assert (ci(2), 0.9347549589238046, 1e-07);
 %! end
 %! % Exact intervals based on normal theory are 0.51 - 0.91
+
+%!test
+%! % Test that checkpointed double bootstrap intervals are reproducible (see
+%! % bootknife for a test of resuming an interrupted run)
+%! data = [48 36 20 29 42 42 20 42 22 41 45 14 6 ...
+%!         0 33 28 34 4 32 24 47 41 24 26 30 41]';
+%! chkfile = cat (2, tempname (), '.mat');
+%! ci1 = bootci (999, {@mean, data}, 'type', 'cal', 'nbootcal', 99, ...
+%!               'checkpoint', chkfile, 'seed', 1);
+%! assert (exist (chkfile, 'file'), 0);
+%! ci2 = bootci (999, {@mean, data}, 'type', 'cal', 'nbootcal', 99, ...
+%!               'checkpoint', chkfile, 'seed', 1);
+%! if (isempty (regexp (which ('boot'), 'mex$')))
+%!   % test boot m-file result
+%!   assert (ci2, ci1);
+%! end
+%! assert (exist (chkfile, 'file'), 0);
+
+%!test
+%! % Test adaptive NBOOT for the intervals computed by bootknife
+%! data = [48 36 20 29 42 42 20 42 22 41 45 14 6 ...
+%!         0 33 28 34 4 32 24 47 41 24 26 30 41]';
+%! for type = {'norm', 'per', 'basic', 'bca'}
+%!   [ci, bootstat] = bootci ([19999, 0.5], {@mean, data}, 'type', type{1});
+%!   assert (size (bootstat), [499, 1]);
+%!   assert (ci(1) < ci(2));
+%! end
+
+%!test
+%! % Test that the jackknife standard errors computed by downdates give the
+%! % same intervals as evaluating BOOTFUN on each of the leave-one-out samples
+%! if (isempty (regexp (which ('boot'), 'mex$')))
+%!   x = randn (20, 1); y = randn (20, 1); X = [ones(20, 1), x];
+%!   g = [ones(12, 1); 2 * ones(8, 1)];
+%!   fun = {@mean, @(x) mean (x); {@var, 1}, @(x) var (x, 1); ...
+%!          @cor, @(x, y) cor (x, y); @mldivide, @(X, y) X \ y};
+%!   data = {{[x, y]}, {x}, {x, y}, {X, y}};
+%!   for i = 1:4
+%!     for strata = {[], g}
+%!       ci1 = bootci (499, {fun{i, 1}, data{i}{:}}, 'type', 'stud', ...
+%!                     'stderr', 'jack', 'strata', strata{1}, 'seed', 1);
+%!       ci2 = bootci (499, {fun{i, 2}, data{i}{:}}, 'type', 'stud', ...
+%!                     'stderr', 'jack', 'strata', strata{1}, 'seed', 1);
+%!       assert (ci1, ci2, 1e-09);
+%!     end
+%!   end
+%! end
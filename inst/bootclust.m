@@ -578,19 +578,19 @@ function [stats, bootstat, X] = bootclust (x, nboot, bootfun, alpha, ...
 
   % Intervals constructed from kernel density estimate of the bootstrap
   % statistics (with shrinkage correction)
-  ci = nan (m, 2);
-  for j = 1 : m
-    try
-      ci(j, :) = parsubfun.kdeinv (probs(j, :), bootstat(j, :), ...
-                         se(j) * sqrt (1 / (nx - 1)), 1 - 1 / (nx - 1));
-    catch
-      % Linear interpolation (legacy)
-      fprintf (strcat ('Note: Falling back to linear interpolation to', ...
-                       ' calculate percentiles for interval pair %u\n'), j);
-      [t1, cdf] = bootcdf (bootstat(j, :), true, 1);
-      ci(j, 1) = interp1 (cdf, t1, probs(1), 'linear', min (t1));
-      ci(j, 2) = interp1 (cdf, t1, probs(2), 'linear', max (t1));
-    end
+  try
+    ci = parsubfun.kdeinv (probs, bootstat, se * sqrt (1 / (nx - 1)), ...
+                           1 - 1 / (nx - 1));
+  catch
+    ci = nan (m, 2);
+  end
+  for j = find (any (isnan (ci), 2))'
+    % Linear interpolation (legacy)
+    fprintf (strcat ('Note: Falling back to linear interpolation to', ...
+                     ' calculate percentiles for interval pair %u\n'), j);
+    [t1, cdf] = bootcdf (bootstat(j, :), true, 1);
+    ci(j, 1) = interp1 (cdf, t1, probs(1), 'linear', min (t1));
+    ci(j, 2) = interp1 (cdf, t1, probs(2), 'linear', max (t1));
   end
 
   % Create STATS output structure
@@ -641,36 +641,70 @@ function X = kdeinv (P, Y, BW, CF)
   % Inverse of the cumulative density function (CDF) of a kernel density 
   % estimate (KDE)
   % 
-  % The function returns X, the inverse CDF of the KDE of Y for the bandwidth
-  % BW evaluated at the values in P. CF is a shrinkage factor for the variance
-  % of the data in Y
+  % The function returns X, the inverse CDF of the KDE of each row of Y for
+  % the bandwidth BW (a scalar or a column vector with a value for each row of
+  % Y) evaluated at the values in the respective row of P. CF is a shrinkage
+  % factor for the variance of the data in Y. The quantiles for all rows and
+  % probabilities are found together by a Newton-Bisection hybrid algorithm,
+  % which uses the analytic density of the KDE and keeps each root bracketed.
+  % Quantiles that cannot be found are returned as NaN.
 
   % Set defaults for optional input arguments
   if (nargin < 4)
     CF = 1;
   end
 
-  % Create Normal CDF function
-  pnorm = @(X, MU, SD) (0.5 * (1 + erf ((X - MU) / (SD * sqrt (2)))));
-
   % Calculate statistics of the data
-  N = numel (Y);
-  MU = mean (Y);
+  [m, N] = size (Y);
+  P = bsxfun (@times, P, ones (m, 1));
+  BW = BW(:) .* ones (m, 1);
+  MU = mean (Y, 2);
 
   % Apply shrinkage correction
-  Y = ((Y - MU) * sqrt (CF)) + MU;
+  Y = bsxfun (@plus, bsxfun (@minus, Y, MU) * sqrt (CF), MU);
 
-  % Set initial values of X0
+  % Set initial values of X and the bracket bounds for each of the roots
   YS = sort (Y, 2);
-  X0 = YS(fix ((N - 1) * P) + 1);
+  X = nan (size (P));
+  X(P == 0) = -Inf;
+  X(P == 1) = +Inf;
+  idx = find ((P > 0) & (P < 1) & (BW(:, ones (1, size (P, 2))) > 0));
+  idx = idx(:);
+  r = mod (idx - 1, m) + 1;   % row of Y for each root
+  p = reshape (P(idx), [], 1);
+  bw = BW(r);
+  x = reshape (YS(sub2ind (size (YS), r, fix ((N - 1) * p) + 1)), [], 1);
+  a = YS(r, 1) - 10 * bw;
+  b = YS(r, N) + 10 * bw;
 
   % Perform root finding to get quantiles of the KDE at values of P
-  findroot = @(X0, P) fzero (@(X) sum (pnorm (X - Y, 0, BW)) / N - P, X0);
-  X = [-Inf, +Inf];
-  for i = 1 : numel(P)
-    if (~ ismember (P(i), [0, 1]))
-      X(i) = findroot (X0(i), P(i));
+  MaxIter = 100;
+  for Iter = 1 : MaxIter
+    if (isempty (idx))
+      break
     end
+    % Evaluate the KDE of the CDF (F) and its density (f) at x
+    Z = bsxfun (@rdivide, bsxfun (@minus, x, Y(r, :)), bw);
+    F = sum (0.5 * (1 + erf (Z / sqrt (2))), 2) / N - p;
+    f = sum (exp (-0.5 * Z.^2), 2) ./ (N * bw * sqrt (2 * pi));
+    step = F ./ f;
+    % Export converged roots and avoid excess computations in following
+    % iterations
+    tol = 1e-12 * max (abs (x), bw);
+    cvg = (F == 0) | (abs (step) <= tol) | ((b - a) <= tol);
+    dx = step(cvg);
+    dx(~ isfinite (dx)) = 0;
+    X(idx(cvg)) = x(cvg) - dx;
+    idx(cvg) = []; r(cvg) = []; p(cvg) = []; bw(cvg) = [];
+    x(cvg) = []; a(cvg) = []; b(cvg) = []; F(cvg) = []; step(cvg) = [];
+    % Update bracket bounds
+    a(F < 0) = x(F < 0);
+    b(F > 0) = x(F > 0);
+    % Prefer Newton step if it is within brackets, otherwise use Bisection
+    nwt = x - step;
+    I = (nwt >= a) & (nwt <= b);
+    x(I) = nwt(I);
+    x(~ I) = 0.5 * (a(~ I) + b(~ I));
   end
 
 end
@@ -31,7 +31,15 @@
 %                  resamples [2,3] for single bootstrap, or
 %       <> vector: A pair of positive integers defining the number of outer and
 %                  inner (nested) resamples for iterated (a.k.a. double)
-%                  bootstrap and coverage calibration [3-6].
+%                  bootstrap and coverage calibration [3-6], or
+%       <> vector: A pair [NBOOT, TOL], where TOL is between 0 and 1, for
+%                  single bootstrap with an adaptive number of resamples. The
+%                  resamples are drawn and evaluated in batches of 499 and
+%                  resampling stops once the Monte Carlo standard errors of
+%                  the (nominal) percentiles of the confidence interval(s), in
+%                  units of the bootstrap standard error, all fall below TOL,
+%                  or once NBOOT resamples have been drawn. The resampling is
+%                  balanced within each batch.
 %        The default value of NBOOT is the scalar: 1999.
 %
 %     'bootknife (DATA, NBOOT, BOOTFUN)' also specifies BOOTFUN: the function
@@ -87,7 +95,9 @@
 %     number of parallel processes to use to accelerate computations of double
 %     bootstrap, jackknife and non-vectorized function evaluations on multicore
 %     machines. This feature requires the Parallel package (in Octave), or the
-%     Parallel Computing Toolbox (in Matlab).
+%     Parallel Computing Toolbox (in Matlab). When BOOTFUN is vectorized, the
+%     inner resamples of the double bootstrap are instead evaluated in large
+%     vectorized blocks and NPROC is not used for them.
 %
 %     'bootknife (DATA, NBOOT, BOOTFUN, ALPHA, STRATA, NPROC, BOOTSAM)' uses
 %     bootstrap resampling indices provided in BOOTSAM. The BOOTSAM should be a
@@ -179,11 +189,13 @@
 
 
 function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
-                             strata, ncpus, bootsam, REF, ISOCTAVE, ERRCHK, LOO)
+                 strata, ncpus, bootsam, REF, ISOCTAVE, ERRCHK, LOO, CHECKPOINT)
 
   % Input argument names in all-caps are for internal use only
-  % REF, ISOCTAVE, ERRCHK and LOO are undocumented input arguments required for
-  % some of the features of bootknife or the functions that require it
+  % REF, ISOCTAVE, ERRCHK, LOO and CHECKPOINT are undocumented input arguments
+  % required for some of the features of bootknife or the functions that
+  % require it. CHECKPOINT is the name of a MAT-file used to save the progress
+  % of the double bootstrap so that an interrupted run can be resumed.
 
   % Store subfunctions in a stucture to make them available for parallel processes
   parsubfun = struct ('col2args', @col2args, ...
@@ -204,13 +216,18 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
       if (numel (nboot) > 2)
         error ('bootknife: NBOOT cannot contain more than 2 values');
       end
-      if (any (nboot ~= abs (fix (nboot))))
-        error ('bootknife: NBOOT must contain positive integers');
+      if ((nboot(1) ~= abs (fix (nboot(1)))) || ((numel (nboot) > 1) && ...
+          (nboot(2) ~= abs (fix (nboot(2)))) && ((nboot(2) <= 0) || ...
+          (nboot(2) >= 1))))
+        error (cat (2, 'bootknife: NBOOT must contain positive integers', ...
+                       ' (or be a pair [NBOOT, TOL], where TOL is between', ...
+                       ' 0 and 1)'));
       end    
       if (numel(nboot) == 1)
         nboot = [nboot, 0];
       end
     end
+    args = {};
     if ((nargin < 3) || isempty (bootfun))
       bootfun = @mean;
       bootfun_str = 'mean';
@@ -305,12 +322,16 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
     end
   else
     szx = 1;
+    bootfun_str = func2str (bootfun);
   end
   if ((nargin < 11) || isempty (LOO))
     % Default has LOO (leave-one-out) set to true for bootknife resampling
     % Undocumented feature for simple bootstrap resampling: set LOO to false
     LOO = true;
   end
+  if ((nargin < 12) || isempty (CHECKPOINT))
+    CHECKPOINT = '';
+  end
 
   % Determine properties of the DATA (x)
   [n, nvar] = size (x);
@@ -318,13 +339,20 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
     error ('bootknife: DATA must be numeric and contain > 1 row')
   end
 
-  % Set number of outer and inner bootknife resamples
+  % Set number of outer and inner bootknife resamples. A second value of NBOOT
+  % that is between 0 and 1 is instead the tolerance (TOL) for adaptive NBOOT
   B = nboot(1);
   if (numel (nboot) > 1)
     C = nboot(2);
   else
     C = 0;
   end
+  tol = 0;
+  if ((C > 0) && (C < 1))
+    tol = C;
+    C = 0;
+    nboot(2) = 0;
+  end
 
   % Evaluate bootfun on the DATA
   T0 = bootfun (x);
@@ -332,6 +360,25 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
     error ('bootknife: BOOTFUN returned NaN with the DATA provided')
   end
 
+  % If there is a checkpoint of an interrupted double bootstrap, resume it from
+  % the outer bootstrap resamples that were saved. The checkpoint must be of
+  % the same DATA (i.e. with the same size and statistic, T0), NBOOT and
+  % BOOTFUN
+  chkpt = [];
+  if (C == 0)
+    CHECKPOINT = '';
+  elseif ((~ isempty (CHECKPOINT)) && (exist (CHECKPOINT, 'file')))
+    chkpt = load (CHECKPOINT);
+    if ((~ all (isfield (chkpt, {'seed', 'nboot', 'T0', 'bootfun'}))) || ...
+        (chkpt.n ~= n) || (chkpt.nvar ~= nvar) || (chkpt.C ~= C) || ...
+        (chkpt.nboot ~= nboot(1)) || (~ isequal (chkpt.T0, T0)) || ...
+        (~ strcmp (chkpt.bootfun, bootfun_str)))
+      error (cat (2, 'bootknife: The CHECKPOINT file does not match the', ...
+                     ' DATA, NBOOT and BOOTFUN'))
+    end
+    bootsam = chkpt.bootsam;
+  end
+
   % Check whether bootfun is vectorized
   if (nvar > 1)
     M = cell2mat (cellfun (@(i) repmat (x(:, i), 1, 2), ...
@@ -454,56 +501,80 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
       [jnk1, jnk2, strata] = unique (strata);
       clear jnk1 jnk2;
     end
-    % Get strata IDs
-    gid = unique (strata);  % strata ID
+    % Get strata IDs and the index (sidx) of the stratum of each row
+    [gid, jnk, sidx] = unique (strata);
+    clear jnk;
     K = numel (gid);        % number of strata
-    % Create strata matrix
-    g = cell2mat (cellfun (@(k) strata == gid(k), num2cell (1 : K), ...
-                           'UniformOutput', false));
-    nk = sum (g);           % strata sample sizes
+    sidx = sidx(:);
+    nk = accumarray (sidx, 1).';   % strata sample sizes
+    % Group the row indices by stratum (rows are sorted by stratum once so
+    % that the rows of each stratum are a contiguous block of ord)
+    [jnk, ord] = sort (sidx);
+    clear jnk;
+    g = mat2cell (ord, nk, 1);
   else 
-    g = ones (n, 1);
+    g = {(1 : n)'};
     K = 1;
   end
 
-  % Perform balanced bootknife resampling
+  % Perform balanced bootknife resampling and evaluate bootfun on each of the
+  % bootstrap resamples. In adaptive mode (TOL > 0), the resamples are drawn by
+  % boot and evaluated in batches (each of which is balanced) until the Monte
+  % Carlo error of the confidence interval endpoints is within tolerance.
   if ((nargin < 7) || isempty (bootsam))
-    if (~ isempty (strata))
-      if (nvar > 1) || (nargout > 2)
-        % We can save some memory by making bootsam an int32 datatype
-        bootsam = zeros (n, B, 'int32');
-        for k = 1 : K
-          if ((sum (g(:, k))) > 1)
-            bootsam(g(:, k), :) = boot (find (g(:, k)), B, LOO);
-          else
-            bootsam(g(:, k), :) = find (g(:, k)) * ones (1, B);
-          end
-        end
+    % If we don't need bootsam, we can save memory by resampling values of x
+    % directly. Otherwise, we can save some memory by making bootsam an int32
+    % datatype
+    keepsam = ((nvar > 1) || (nargout > 2) || (~ isempty (CHECKPOINT)));
+    if (tol > 0)
+      if (keepsam)
+        bootsam = zeros (n, 0, 'int32');
       else
-        % For more efficiency, if we don't need bootsam, we can directly
-        % resample values of x
         bootsam = [];
-        X = zeros (n, B);
-        for k = 1 : K
-          if ((sum (g(:, k))) > 1)
-            X(g(:, k), :) = boot (x(g(:, k), :), B, LOO);
+        X = zeros (n, 0);
+      end
+      bootstat = zeros (m, 0);
+      if (~ isnan (alpha))
+        if (numel (alpha) > 1)
+          probs = alpha;
+        else
+          probs = [alpha / 2, 1 - alpha / 2];
+        end
+      end
+      B = 0;
+      while (B < nboot(1))
+        nb = min (499, nboot(1) - B);
+        [bs, Xb] = bootsample (x, nb, LOO, g, strata, keepsam);
+        if (keepsam)
+          bootsam(:, B + (1 : nb)) = bs;
+        else
+          X(:, B + (1 : nb)) = Xb;
+        end
+        bootstat(:, B + (1 : nb)) = bootevals (x, Xb, bs, bootfun, ...
+                                               vectorized, ncpus, ISOCTAVE);
+        B = B + nb;
+        % Stopping rule: the Monte Carlo standard errors of the (nominal)
+        % percentiles of the intervals, in units of the standard error
+        if (B < nboot(1))
+          T = bootstat(:, all (isfinite (bootstat), 1));
+          if (size (T, 2) < 2)
+            continue
+          end
+          if (isnan (alpha))
+            mcse = 1 / sqrt (size (T, 2));
           else
-            X(g(:, k), :) = x(g(:, k), :) * ones (1, B);
+            mcse = bsxfun (@rdivide, cat (2, quantse (T, probs(1)), ...
+                                             quantse (T, probs(2))), ...
+                           std (T, 0, 2));
+          end
+          if (all (mcse(:) <= tol))
+            break
           end
         end
       end
+      nboot(1) = B;
     else
-      if (nvar > 1) || (nargout > 2)
-        % Resample the sample indices, which we will refer to as bootsam
-        % We can save some memory by making bootsam an int32 datatype
-        bootsam = zeros (n, B, 'int32');
-        bootsam(:, :) = boot (n, B, LOO);
-      else
-        % For more efficiency, if we don't need bootsam, we can directly
-        % resample values of x
-        bootsam = [];
-        X = boot (x, B, LOO);
-      end
+      [bootsam, X] = bootsample (x, B, LOO, g, strata, keepsam);
     end
   else
     if (size (bootsam, 1) ~= n)
@@ -511,67 +582,26 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
     end
     nboot(1) = size (bootsam, 2);
     B = nboot(1);
+    tol = 0;
+  end
+  if ((~ isempty (CHECKPOINT)) && (isempty (chkpt)))
+    % Save the outer bootstrap resamples and a base seed, from which the seeds
+    % of the inner layer of resampling are derived, before it starts
+    chkpt = struct ('n', n, 'nvar', nvar, 'C', C, 'nboot', nboot(1), ...
+                    'T0', T0, 'bootfun', bootfun_str, 'bootsam', bootsam, ...
+                    'done', 0, 'mu', [], 'V', [], 'U', [], ...
+                    'seed', floor (rand * 2^32));
+    savecheckpoint (CHECKPOINT, chkpt);
   end
 
   % Evaluate bootfun each bootstrap resample
-  if (isempty (bootsam))
-    if (vectorized)
-      % Vectorized evaluation of bootfun on the DATA resamples
-      bootstat = bootfun (X);
+  if (tol == 0)
+    if (isempty (bootsam))
+      bootstat = bootevals (x, X, [], bootfun, vectorized, ncpus, ISOCTAVE);
     else
-      if (ncpus > 1)
-        % Evaluate bootfun on each bootstrap resample in PARALLEL
-        if (ISOCTAVE)
-          % OCTAVE
-          bootstat = parcellfun (ncpus, bootfun, num2cell (X, 1), ...
-                                 'UniformOutput', false);
-        else
-          % MATLAB
-          bootstat = cell (1, B);
-          parfor b = 1 : B; bootstat{b} = bootfun (X(:, b)); end
-        end
-      else
-        bootstat = cellfun (bootfun, num2cell (X, 1), 'UniformOutput', false);
-      end
+      bootstat = bootevals (x, [], bootsam, bootfun, vectorized, ncpus, ...
+                            ISOCTAVE);
     end
-  else
-    if (vectorized)
-      % DATA resampling (using bootsam) and vectorized evaluation of bootfun on 
-      % the DATA resamples 
-      if (nvar > 1)
-        % Multivariate
-        % Perform DATA sampling
-        X = cell2mat (cellfun (@(i) reshape (x(bootsam, i), n, B), ...
-                      num2cell (1 : nvar, 1), 'UniformOutput', false));
-      else
-        % Univariate
-        % Perform DATA sampling
-        X = x(bootsam);
-      end
-      % Function evaluation on bootknife samples
-      bootstat = bootfun (X);
-    else 
-      cellfunc = @(bootsam) bootfun (x(bootsam, :));
-      if (ncpus > 1)
-        % Evaluate bootfun on each bootstrap resample in PARALLEL
-        if (ISOCTAVE)
-          % OCTAVE
-          bootstat = parcellfun (ncpus, cellfunc, num2cell (bootsam, 1), ...
-                                 'UniformOutput', false);
-        else
-          % MATLAB
-          bootstat = cell (1, B);
-          parfor b = 1 : B; bootstat{b} = cellfunc (bootsam(:, b)); end
-        end
-      else
-        % Evaluate bootfun on each bootstrap resample in SERIAL
-        bootstat = cellfun (cellfunc, num2cell (bootsam, 1), ...
-                            'UniformOutput', false);
-      end
-    end
-  end
-  if (iscell (bootstat))
-    bootstat = cell2mat (bootstat);
   end
   
   % Remove bootstrap statistics that contain NaN or Inf, along with their
@@ -593,67 +623,68 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
   if (C > 0)
 
     %%%%%%%%%%%%%%%%%%%%%%%%%%% DOUBLE BOOTSTRAP %%%%%%%%%%%%%%%%%%%%%%%%%%%
-    if (ncpus > 1)
-      % PARALLEL execution of inner layer resampling for double (i.e. iterated)
-      % bootstrap
+    if ((~ vectorized) && (ncpus > 1) && (isempty (CHECKPOINT)))
+      % Set unique random seed for each parallel thread
       if (ISOCTAVE)
         % OCTAVE
-        % Set unique random seed for each parallel thread
         pararrayfun (ncpus, @boot, 1, 1, false, 1 : ncpus);
-        if (vectorized && isempty (bootsam))
-          cellfunc = @(x) bootknife (x, C, bootfun, NaN, strata, 0, [], T0, ...
-                                     ISOCTAVE, false, LOO);
-          bootout = parcellfun (ncpus, cellfunc, num2cell (X, 1), ...
-                                'UniformOutput', false);
-        else
-          cellfunc = @(bootsam) bootknife (x(bootsam, :), C, bootfun, NaN, ...
-                                     strata, 0, [], T0, ISOCTAVE, false, LOO);
-          bootout = parcellfun (ncpus, cellfunc, num2cell (bootsam, 1), ...
-                                'UniformOutput', false);
-        end
       else
         % MATLAB
-        % Set unique random seed for each parallel thread
         parfor i = 1 : ncpus; boot (1, 1, false, i); end
-        % Perform inner layer of resampling
-        % Preallocate structure array
-        bootout = cell (1, B);
-        if (vectorized && isempty (bootsam))
-          cellfunc = @(x) bootknife (x, C, bootfun, NaN, strata, 0, [], T0, ...
-                                     ISOCTAVE, false, LOO);
-          parfor b = 1 : B; bootout{b} = cellfunc (X(:, b)); end
-        else
-          cellfunc = @(bootsam) bootknife (x(bootsam, :), C, bootfun, NaN, ...
-                                     strata, 0, [], T0, ISOCTAVE, false);
-          parfor b = 1 : B; bootout{b} = cellfunc (bootsam(:, b)); end
-        end
       end
+    end
+    if (isempty (CHECKPOINT))
+      [mu, V, U] = innerboot (x, X, bootsam, C, bootfun, T0, g, strata, ...
+                              LOO, vectorized, ncpus, ISOCTAVE);
     else
-      % SERIAL execution of inner layer resampling for double bootstrap
-      if (vectorized && isempty (bootsam))
-        cellfunc = @(x) bootknife (x, C, bootfun, NaN, strata, 0, [], T0, ...
-                                   ISOCTAVE, false, LOO);
-        bootout = cellfun (cellfunc, num2cell (X, 1), 'UniformOutput', false);
-      else
-        cellfunc = @(bootsam) bootknife (x(bootsam, :), C, bootfun, NaN, ...
-                                       strata, 0, [], T0, ISOCTAVE, false, LOO);
-        bootout = cellfun (cellfunc, num2cell (bootsam, 1), ...
-                           'UniformOutput', false);
+      % Perform the inner layer of resampling on chunks of the outer resamples.
+      % The inner resamples of each outer resample are drawn by boot with an
+      % explicit seed, derived from the base seed saved in the CHECKPOINT file
+      % and the index of the outer resample, so that they do not depend on the
+      % order or the process in which they are drawn (or on whether boot is the
+      % MEX file, which does not keep the state of its generator between
+      % calls). At most once a minute, and if an error interrupts the
+      % computations, the summaries of the inner bootstrap distributions
+      % completed so far are saved to the CHECKPOINT file, so that a resumed
+      % run continues exactly where the interrupted run left off.
+      mu = zeros (m, B);
+      V = zeros (m, B);
+      U = zeros (m, B);
+      done = chkpt.done;
+      mu(:, 1 : done) = chkpt.mu;
+      V(:, 1 : done) = chkpt.V;
+      U(:, 1 : done) = chkpt.U;
+      seeds = mod (chkpt.seed + (0 : B - 1) * K, 2^32);
+      chksz = max (1, fix (B / 100));
+      t = tic;
+      try
+        for b = chkpt.done + 1 : chksz : B
+          idx = b : min (b + chksz - 1, B);
+          [mu(:, idx), V(:, idx), U(:, idx)] = innerboot (x, [], ...
+                                  bootsam(:, idx), C, bootfun, T0, g, strata, ...
+                                  LOO, vectorized, ncpus, ISOCTAVE, seeds(idx));
+          done = idx(end);
+          if ((toc (t) > 60) && (done < B))
+            chkpt = saveprogress (CHECKPOINT, chkpt, mu, V, U, done);
+            t = tic;
+          end
+        end
+      catch err
+        if (done > chkpt.done)
+          saveprogress (CHECKPOINT, chkpt, mu, V, U, done);
+        end
+        rethrow (err);
       end
+      delete (CHECKPOINT);
     end
     % Double bootstrap bias estimation
-    mu = cell2mat (cellfun (@(S) S.bias, bootout, 'UniformOutput', false)) + ...
-         cell2mat (cellfun (@(S) S.original, bootout, 'UniformOutput', false));
     b = mean (bootstat, 2) - T0;
     c = mean (mu, 2) - 2 * mean (bootstat, 2) + T0;
     bias = b - c;
     % Double bootstrap multiplicative correction of the standard error
-    V = cell2mat (cellfun (@(S) S.std_error.^2, bootout, ...
-                           'UniformOutput', false));
     se = sqrt (var (bootstat, 0, 2).^2 ./ mean (V, 2));
     % Double bootstrap confidence intervals
     if (~ isnan (alpha))
-      U = cell2mat (cellfun (@(S) S.Pr, bootout, 'UniformOutput', false));
       l = zeros (m, 2);
       ci = zeros (m, 2);
       for j = 1 : m
@@ -718,17 +749,8 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
           try
             if (vectorized)
               % Leave-one-out DATA resampling followed by vectorized function
-              % evaluations
-              if (nvar > 1)
-                % Multivariate
-                T = bootfun (reshape (cell2mat (arrayfun (...
-                             @(i) x(1 : n ~= i, :), (1 : n)', ...
-                             'UniformOutput', false)), n - 1, []));
-              else
-                % Univariate
-                T = bootfun (cell2mat (arrayfun (@(i) x(1 : n ~= i, :), ...
-                             (1 : n), 'UniformOutput', false)));
-              end
+              % evaluations (or leave-one-out downdates of simple statistics)
+              T = loostat (x, bootfun, bootfun_str, args);
             else
               % Leave-one-out DATA resampling followed by looped function
               % evaluations (if bootfun is not vectorized)
@@ -751,7 +773,7 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
             end
             % Calculate empirical influence function
             if (~ isempty (strata))
-              gk = sum (g .* repmat (nk, n, 1), 2).';
+              gk = nk(sidx);
               U = bsxfun (@times, gk - 1, bsxfun (@minus, T0, T));
             else
               U = (n - 1) * bsxfun (@minus, T0, T);
@@ -783,23 +805,22 @@ function [stats, bootstat, bootsam] = bootknife (x, nboot, bootfun, alpha, ...
       end
       % Intervals constructed from kernel density estimate of the bootstrap
       % (with shrinkage correction)
-      ci = zeros (m, 2);
-      for j = 1 : m
+      ci = nan (m, 2);
+      if (LOO)
         try
-          if (LOO)
-            ci(j, :) = parsubfun.kdeinv (l(j, :), bootstat(j, :), ...
-                                   se(j) * sqrt (1 / (n - K)), 1 - 1 / (n - K));
-          else
-            error ('bootknife: Invoke linear interpolation method.')
-          end
+          ci = parsubfun.kdeinv (l, bootstat, se * sqrt (1 / (n - K)), ...
+                                 1 - 1 / (n - K));
         catch
-          % Linear interpolation (legacy) when LOO is false and for corner cases
-          % where KDE fails
-          [t1, cdf] = bootcdf (bootstat(j, :), true, 1);
-          ci(j, 1) = interp1 (cdf, t1, l(j, 1), 'linear', min (t1));
-          ci(j, 2) = interp1 (cdf, t1, l(j, 2), 'linear', max (t1));
+          ci = nan (m, 2);
         end
       end
+      for j = find (any (isnan (ci), 2))'
+        % Linear interpolation (legacy) when LOO is false and for corner cases
+        % where KDE fails
+        [t1, cdf] = bootcdf (bootstat(j, :), true, 1);
+        ci(j, 1) = interp1 (cdf, t1, l(j, 1), 'linear', min (t1));
+        ci(j, 2) = interp1 (cdf, t1, l(j, 2), 'linear', max (t1));
+      end
       warning (state);
       if (ISOCTAVE)
         warning ('off', 'quiet');
@@ -972,41 +993,532 @@ end
 
 %--------------------------------------------------------------------------
 
+function [bootsam, X] = bootsample (x, B, LOO, g, strata, keepsam)
+
+  % Usage: [bootsam, X] = bootsample (x, B, LOO, g, strata, keepsam)
+  % Draws B balanced bootknife resamples (or bootstrap resamples if LOO is
+  % false) from the rows of x, within each stratum (if strata is not empty),
+  % where g is a cell array of the row indices of each stratum. If keepsam is
+  % true, the resampling indices are returned in bootsam (as int32) and X is
+  % empty. Otherwise, the values of x are resampled directly into X and bootsam
+  % is empty.
+
+  n = size (x, 1);
+  K = numel (g);
+  if (keepsam)
+    bootsam = zeros (n, B, 'int32');
+    X = [];
+  else
+    bootsam = [];
+  end
+  if (~ isempty (strata))
+    if (~ keepsam)
+      X = zeros (n, B);
+    end
+    for k = 1 : K
+      if (numel (g{k}) > 1)
+        if (keepsam)
+          bootsam(g{k}, :) = boot (g{k}, B, LOO);
+        else
+          X(g{k}, :) = boot (x(g{k}, :), B, LOO);
+        end
+      else
+        if (keepsam)
+          bootsam(g{k}, :) = g{k} * ones (1, B);
+        else
+          X(g{k}, :) = x(g{k}, :) * ones (1, B);
+        end
+      end
+    end
+  else
+    if (keepsam)
+      bootsam(:, :) = boot (n, B, LOO);
+    else
+      X = boot (x, B, LOO);
+    end
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function bootstat = bootevals (x, X, bootsam, bootfun, vectorized, ncpus, ...
+                               ISOCTAVE)
+
+  % Usage: bootstat = bootevals (x, X, bootsam, bootfun, vectorized, ncpus, ...
+  %                              ISOCTAVE)
+  % Evaluates bootfun on each bootstrap resample, which are either the columns
+  % of X (if bootsam is empty) or the DATA rows x(bootsam(:, b), :)
+
+  if (isempty (bootsam))
+    B = size (X, 2);
+    if (vectorized)
+      % Vectorized evaluation of bootfun on the DATA resamples
+      bootstat = bootfun (X);
+    else
+      if (ncpus > 1)
+        % Evaluate bootfun on each bootstrap resample in PARALLEL
+        if (ISOCTAVE)
+          % OCTAVE
+          bootstat = parcellfun (ncpus, bootfun, num2cell (X, 1), ...
+                                 'UniformOutput', false);
+        else
+          % MATLAB
+          bootstat = cell (1, B);
+          parfor b = 1 : B; bootstat{b} = bootfun (X(:, b)); end
+        end
+      else
+        bootstat = cellfun (bootfun, num2cell (X, 1), 'UniformOutput', false);
+      end
+    end
+  else
+    [n, B] = size (bootsam);
+    nvar = size (x, 2);
+    if (vectorized)
+      % DATA resampling (using bootsam) and vectorized evaluation of bootfun on 
+      % the DATA resamples 
+      if (nvar > 1)
+        % Multivariate
+        % Perform DATA sampling
+        X = cell2mat (cellfun (@(i) reshape (x(bootsam, i), n, B), ...
+                      num2cell (1 : nvar, 1), 'UniformOutput', false));
+      else
+        % Univariate
+        % Perform DATA sampling
+        X = x(bootsam);
+      end
+      % Function evaluation on bootknife samples
+      bootstat = bootfun (X);
+    else 
+      cellfunc = @(bootsam) bootfun (x(bootsam, :));
+      if (ncpus > 1)
+        % Evaluate bootfun on each bootstrap resample in PARALLEL
+        if (ISOCTAVE)
+          % OCTAVE
+          bootstat = parcellfun (ncpus, cellfunc, num2cell (bootsam, 1), ...
+                                 'UniformOutput', false);
+        else
+          % MATLAB
+          bootstat = cell (1, B);
+          parfor b = 1 : B; bootstat{b} = cellfunc (bootsam(:, b)); end
+        end
+      else
+        % Evaluate bootfun on each bootstrap resample in SERIAL
+        bootstat = cellfun (cellfunc, num2cell (bootsam, 1), ...
+                            'UniformOutput', false);
+      end
+    end
+  end
+  if (iscell (bootstat))
+    bootstat = cell2mat (bootstat);
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function T = loostat (x, bootfun, bootfun_str, args)
+
+  % Usage: T = loostat (x, bootfun, bootfun_str, args)
+  % Evaluates a vectorized bootfun on each of the leave-one-out (jackknife)
+  % resamples of x. For the mean and variance of univariate data, the
+  % statistics are computed directly by O(n) downdates of the full sample
+  % sums. Otherwise, the jackknife resamples are gathered from a matrix of
+  % sample indices in blocks of columns to limit memory usage.
+
+  [n, nvar] = size (x);
+  if (nvar == 1)
+    switch (lower (bootfun_str))
+      case 'mean'
+        if (isempty (args))
+          T = (sum (x) - x.') / (n - 1);
+          return
+        end
+      case 'var'
+        % Normalization option for the variance (0 or 1)
+        opt = [args, {0}];
+        opt = opt{1};
+        if (isempty (opt))
+          opt = 0;
+        end
+        if ((n > 2) && (numel (args) < 2) && (isequal (opt, 0) || ...
+                                              isequal (opt, 1)))
+          % Sum of squared deviations from the mean after leaving out each
+          % observation, computed from the deviations from the full sample mean
+          d = x - mean (x);
+          SS = max (sum (d.^2) - d.'.^2 * n / (n - 1), 0);
+          T = SS / (n - 2 + opt);
+          return
+        end
+    end
+  end
+
+  % Matrix of sample indices of the leave-one-out resamples, built for one
+  % block of columns at a time
+  blksz = max (1, fix (1e+07 / ((n - 1) * nvar)));
+  T = [];
+  for i = 1 : blksz : n
+    idx = i : min (i + blksz - 1, n);
+    Jb = bsxfun (@plus, (1 : n - 1)', bsxfun (@ge, (1 : n - 1)', idx));
+    if (nvar > 1)
+      % Multivariate
+      X = cell2mat (cellfun (@(v) reshape (x(Jb, v), n - 1, []), ...
+                    num2cell (1 : nvar, 1), 'UniformOutput', false));
+    else
+      % Univariate
+      X = x(Jb);
+    end
+    T = cat (2, T, bootfun (X));
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function [MU, V, U] = innerboot (x, X, bootsam, C, bootfun, T0, g, strata, ...
+                                  LOO, vectorized, ncpus, ISOCTAVE, SEEDS)
+
+  % Usage: [MU, V, U] = innerboot (x, X, bootsam, C, bootfun, T0, g, ...
+  %                                strata, LOO, vectorized, ncpus, ISOCTAVE)
+  %        [MU, V, U] = innerboot (..., SEEDS)
+  % Inner layer of resampling for the double bootstrap of the outer bootstrap
+  % resamples in the columns of X (or of bootsam if X is empty). Returned are
+  % the mean (MU) and variance (V) of the inner bootstrap statistics, and the
+  % proportion (U) of them that are <= T0, for each outer resample. If SEEDS
+  % is provided (which requires bootsam), the inner resamples of outer
+  % resample b are drawn by boot with the seed SEEDS(b) (see innersam).
+
+  B = max (size (X, 2), size (bootsam, 2));
+  if ((nargin < 13) || isempty (SEEDS))
+    INNER = cell (1, B);
+  else
+    n = size (x, 1);
+    INNER = arrayfun (@(s) innersam (n, C, LOO, g, strata, s), SEEDS, ...
+                      'UniformOutput', false);
+  end
+  if (vectorized)
+    % Vectorized execution of inner layer resampling for double bootstrap.
+    % The inner resamples for a block of outer resamples are drawn exactly as
+    % they would be by recursive calls to bootknife, but bootfun is evaluated
+    % on all of them at once and only the summaries of the inner bootstrap
+    % distributions are kept
+    [MU, V, U] = nestedboot (x, X, bootsam, C, bootfun, T0, g, strata, ...
+                             LOO, INNER);
+  elseif (ncpus > 1)
+    % PARALLEL execution of inner layer resampling for double (i.e. iterated)
+    % bootstrap
+    if (ISOCTAVE)
+      % OCTAVE
+      if (vectorized && isempty (bootsam))
+        cellfunc = @(x) bootknife (x, C, bootfun, NaN, strata, 0, [], T0, ...
+                                   ISOCTAVE, false, LOO);
+        bootout = parcellfun (ncpus, cellfunc, num2cell (X, 1), ...
+                              'UniformOutput', false);
+      else
+        cellfunc = @(bootsam, bs) bootknife (x(bootsam, :), C, bootfun, ...
+                               NaN, strata, 0, bs, T0, ISOCTAVE, false, LOO);
+        bootout = parcellfun (ncpus, cellfunc, num2cell (bootsam, 1), INNER, ...
+                              'UniformOutput', false);
+      end
+    else
+      % MATLAB
+      % Perform inner layer of resampling
+      % Preallocate structure array
+      bootout = cell (1, B);
+      if (vectorized && isempty (bootsam))
+        cellfunc = @(x) bootknife (x, C, bootfun, NaN, strata, 0, [], T0, ...
+                                   ISOCTAVE, false, LOO);
+        parfor b = 1 : B; bootout{b} = cellfunc (X(:, b)); end
+      else
+        cellfunc = @(bootsam, bs) bootknife (x(bootsam, :), C, bootfun, ...
+                               NaN, strata, 0, bs, T0, ISOCTAVE, false);
+        parfor b = 1 : B; bootout{b} = cellfunc (bootsam(:, b), INNER{b}); end
+      end
+    end
+  else
+    % SERIAL execution of inner layer resampling for double bootstrap
+    if (vectorized && isempty (bootsam))
+      cellfunc = @(x) bootknife (x, C, bootfun, NaN, strata, 0, [], T0, ...
+                                 ISOCTAVE, false, LOO);
+      bootout = cellfun (cellfunc, num2cell (X, 1), 'UniformOutput', false);
+    else
+      cellfunc = @(bootsam, bs) bootknife (x(bootsam, :), C, bootfun, ...
+                               NaN, strata, 0, bs, T0, ISOCTAVE, false, LOO);
+      bootout = cellfun (cellfunc, num2cell (bootsam, 1), INNER, ...
+                         'UniformOutput', false);
+    end
+  end
+  if (~ vectorized)
+    % Collect the summaries of the inner bootstrap distributions
+    MU = cell2mat (cellfun (@(S) S.bias, bootout, 'UniformOutput', false)) + ...
+         cell2mat (cellfun (@(S) S.original, bootout, 'UniformOutput', false));
+    V = cell2mat (cellfun (@(S) S.std_error.^2, bootout, ...
+                           'UniformOutput', false));
+    U = cell2mat (cellfun (@(S) S.Pr, bootout, 'UniformOutput', false));
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function savecheckpoint (CHECKPOINT, chkpt)
+
+  % Write the checkpoint to a temporary file before replacing the previous one
+  % so that an interruption while saving cannot corrupt the CHECKPOINT file
+  tmpfile = cat (2, CHECKPOINT, '.tmp');
+  save (tmpfile, '-struct', 'chkpt', '-v7');
+  movefile (tmpfile, CHECKPOINT, 'f');
+
+end
+
+%--------------------------------------------------------------------------
+
+function chkpt = saveprogress (CHECKPOINT, chkpt, mu, V, U, done)
+
+  % Save the summaries of the inner bootstrap distributions of the first done
+  % outer resamples to the CHECKPOINT file
+  chkpt.done = done;
+  chkpt.mu = mu(:, 1 : done);
+  chkpt.V = V(:, 1 : done);
+  chkpt.U = U(:, 1 : done);
+  savecheckpoint (CHECKPOINT, chkpt);
+
+end
+
+%--------------------------------------------------------------------------
+
+function bs = innersam (n, C, LOO, g, strata, seed)
+
+  % Draw C inner bootknife resamples of the n rows of an outer resample, as a
+  % recursive call to bootknife would, except that boot is called with the
+  % explicit seed, seed + k - 1, for stratum k
+  if (isempty (strata))
+    bs = boot (n, C, LOO, seed);
+  else
+    bs = zeros (n, C);
+    for k = 1 : numel (g)
+      if (numel (g{k}) > 1)
+        bs(g{k}, :) = boot (g{k}, C, LOO, mod (seed + k - 1, 2^32));
+      else
+        bs(g{k}, :) = g{k} * ones (1, C);
+      end
+    end
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function [MU, V, U] = nestedboot (x, X, bootsam, C, bootfun, T0, g, strata, ...
+                                   LOO, INNER)
+
+  % Usage: [MU, V, U] = nestedboot (x, X, bootsam, C, bootfun, T0, g, strata, ...
+  %                                 LOO, INNER)
+  % Inner layer of resampling for the double bootstrap when bootfun is
+  % vectorized. For each outer bootstrap resample (the columns of X, or of
+  % bootsam if X is empty), C inner bootknife resamples are drawn using the
+  % same calls to boot as a recursive call to bootknife would make, so the
+  % results are unchanged for a given random seed. bootfun is then evaluated on
+  % the inner resamples of a block of outer resamples at once. Returned are the
+  % mean (MU) and variance (V) of the inner bootstrap statistics, and the
+  % interpolated proportion (U) of them that are <= T0, for each outer resample.
+  % If INNER{b} is not empty, it contains the (row) indices of the inner
+  % resamples of outer resample b, which are then used instead of calling boot.
+
+  [n, nvar] = size (x);
+  m = numel (T0);
+  K = numel (g);
+  if (isempty (bootsam))
+    B = size (X, 2);
+  else
+    B = size (bootsam, 2);
+  end
+  MU = zeros (m, B);
+  V = zeros (m, B);
+  U = zeros (m, B);
+
+  % Process the outer resamples in blocks to limit memory usage
+  blksz = max (1, fix (1e+07 / (n * C * nvar)));
+  for b = 1 : blksz : B
+    idx = b : min (b + blksz - 1, B);
+    nb = numel (idx);
+
+    % Draw the inner resamples of each outer resample in the block
+    if (nvar > 1)
+      J = zeros (n, C * nb);
+    else
+      Xi = zeros (n, C * nb);
+    end
+    for i = 1 : nb
+      cols = (i - 1) * C + (1 : C);
+      if (~ isempty (INNER{idx(i)}))
+        % Inner resamples drawn beforehand (see innersam)
+        bs = INNER{idx(i)};
+        if (nvar > 1)
+          bsam = bootsam(:, idx(i));
+          J(:, cols) = bsam(bs);
+        elseif (isempty (bootsam))
+          xb = X(:, idx(i));
+          Xi(:, cols) = xb(bs);
+        else
+          xb = x(bootsam(:, idx(i)));
+          Xi(:, cols) = xb(bs);
+        end
+      elseif (nvar > 1)
+        % Multivariate: resample the sample indices of the outer resample
+        if (isempty (strata))
+          bs = boot (n, C, LOO);
+        else
+          bs = zeros (n, C);
+          for k = 1 : K
+            if (numel (g{k}) > 1)
+              bs(g{k}, :) = boot (g{k}, C, LOO);
+            else
+              bs(g{k}, :) = g{k} * ones (1, C);
+            end
+          end
+        end
+        bsam = bootsam(:, idx(i));
+        J(:, cols) = bsam(bs);
+      else
+        % Univariate: resample the values of the outer resample
+        if (isempty (bootsam))
+          xb = X(:, idx(i));
+        else
+          xb = x(bootsam(:, idx(i)));
+        end
+        if (isempty (strata))
+          Xi(:, cols) = boot (xb, C, LOO);
+        else
+          for k = 1 : K
+            if (numel (g{k}) > 1)
+              Xi(g{k}, cols) = boot (xb(g{k}), C, LOO);
+            else
+              Xi(g{k}, cols) = xb(g{k}) * ones (1, C);
+            end
+          end
+        end
+      end
+    end
+    if (nvar > 1)
+      Xi = cell2mat (cellfun (@(v) reshape (x(J, v), n, C * nb), ...
+                     num2cell (1 : nvar, 1), 'UniformOutput', false));
+    end
+
+    % Vectorized evaluation of bootfun on all of the inner resamples
+    T = reshape (bootfun (Xi), m, C, nb);
+
+    % Exclude inner bootstrap statistics that contain NaN or Inf
+    ok = repmat (all (isfinite (T), 1), [m, 1, 1]);
+    Bi = sum (ok, 2);
+    if (any (Bi(:) == 0))
+      error ('bootknife: BOOTFUN returned NaN for every bootstrap resample')
+    end
+    T(~ ok) = 0;
+
+    % Mean and (unbiased) variance of the inner bootstrap statistics
+    M = sum (T, 2) ./ Bi;
+    D = bsxfun (@minus, T, M) .* ok;
+    S2 = sum (D.^2, 2) ./ max (Bi - 1, 1);
+
+    % Use quick interpolation to find the proportion of the inner bootstrap
+    % statistics <= T0
+    I = bsxfun (@le, T, T0) & ok;
+    pr = sum (I, 2);
+    A = T; A(~ ok) = Inf;
+    tmin = min (A, [], 2);
+    A = T; A(~ ok) = -Inf;
+    tmax = max (A, [], 2);
+    A = T; A(~ I) = -Inf;
+    t1 = max (tmin, max (A, [], 2));
+    A = T; A(~ (ok & ~ I)) = Inf;
+    t2 = min (tmax, min (A, [], 2));
+    dt = t2 - t1;
+    REF = repmat (T0, [1, 1, nb]);
+    chk = (pr < Bi) & (dt > 0);
+    Pr = pr;
+    Pr(chk) = pr(chk) + ((REF(chk) - t1(chk)) .* ...
+                         (min (pr(chk) + 1, Bi(chk)) - pr(chk)) ./ dt(chk));
+
+    MU(:, idx) = reshape (M, m, nb);
+    V(:, idx) = reshape (S2, m, nb);
+    U(:, idx) = reshape (max (Pr, 1) ./ (Bi + 1), m, nb);
+
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
 function X = kdeinv (P, Y, BW, CF)
 
   % Inverse of the cumulative density function (CDF) of a kernel density 
   % estimate (KDE)
   % 
-  % The function returns X, the inverse CDF of the KDE of Y for the bandwidth
-  % BW evaluated at the values in P. CF is a shrinkage factor for the variance
-  % of the data in Y
+  % The function returns X, the inverse CDF of the KDE of each row of Y for
+  % the bandwidth BW (a scalar or a column vector with a value for each row of
+  % Y) evaluated at the values in the respective row of P. CF is a shrinkage
+  % factor for the variance of the data in Y. The quantiles for all rows and
+  % probabilities are found together by a Newton-Bisection hybrid algorithm,
+  % which uses the analytic density of the KDE and keeps each root bracketed.
+  % Quantiles that cannot be found are returned as NaN.
 
   % Set defaults for optional input arguments
   if (nargin < 4)
     CF = 1;
   end
 
-  % Create Normal CDF function
-  pnorm = @(X, MU, SD) (0.5 * (1 + erf ((X - MU) / (SD * sqrt (2)))));
-
   % Calculate statistics of the data
-  N = numel (Y);
-  MU = mean (Y);
+  [m, N] = size (Y);
+  P = bsxfun (@times, P, ones (m, 1));
+  BW = BW(:) .* ones (m, 1);
+  MU = mean (Y, 2);
 
   % Apply shrinkage correction
-  Y = ((Y - MU) * sqrt (CF)) + MU;
+  Y = bsxfun (@plus, bsxfun (@minus, Y, MU) * sqrt (CF), MU);
 
-  % Set initial values of X0
+  % Set initial values of X and the bracket bounds for each of the roots
   YS = sort (Y, 2);
-  X0 = YS(fix ((N - 1) * P) + 1);
+  X = nan (size (P));
+  X(P == 0) = -Inf;
+  X(P == 1) = +Inf;
+  idx = find ((P > 0) & (P < 1) & (BW(:, ones (1, size (P, 2))) > 0));
+  idx = idx(:);
+  r = mod (idx - 1, m) + 1;   % row of Y for each root
+  p = reshape (P(idx), [], 1);
+  bw = BW(r);
+  x = reshape (YS(sub2ind (size (YS), r, fix ((N - 1) * p) + 1)), [], 1);
+  a = YS(r, 1) - 10 * bw;
+  b = YS(r, N) + 10 * bw;
 
   % Perform root finding to get quantiles of the KDE at values of P
-  findroot = @(X0, P) fzero (@(X) sum (pnorm (X - Y, 0, BW)) / N - P, X0);
-  X = [-Inf, +Inf];
-  for i = 1 : numel(P)
-    if (~ ismember (P(i), [0, 1]))
-      X(i) = findroot (X0(i), P(i));
+  MaxIter = 100;
+  for Iter = 1 : MaxIter
+    if (isempty (idx))
+      break
     end
+    % Evaluate the KDE of the CDF (F) and its density (f) at x
+    Z = bsxfun (@rdivide, bsxfun (@minus, x, Y(r, :)), bw);
+    F = sum (0.5 * (1 + erf (Z / sqrt (2))), 2) / N - p;
+    f = sum (exp (-0.5 * Z.^2), 2) ./ (N * bw * sqrt (2 * pi));
+    step = F ./ f;
+    % Export converged roots and avoid excess computations in following
+    % iterations
+    tol = 1e-12 * max (abs (x), bw);
+    cvg = (F == 0) | (abs (step) <= tol) | ((b - a) <= tol);
+    dx = step(cvg);
+    dx(~ isfinite (dx)) = 0;
+    X(idx(cvg)) = x(cvg) - dx;
+    idx(cvg) = []; r(cvg) = []; p(cvg) = []; bw(cvg) = [];
+    x(cvg) = []; a(cvg) = []; b(cvg) = []; F(cvg) = []; step(cvg) = [];
+    % Update bracket bounds
+    a(F < 0) = x(F < 0);
+    b(F > 0) = x(F > 0);
+    % Prefer Newton step if it is within brackets, otherwise use Bisection
+    nwt = x - step;
+    I = (nwt >= a) & (nwt <= b);
+    x(I) = nwt(I);
+    x(~ I) = 0.5 * (a(~ I) + b(~ I));
   end
 
 end
@@ -1532,12 +2044,28 @@ end
 %!   stats = bootknife ({X,y}, 1999, @mldivide, [], strata);
 %!   stats = bootknife ({X,y}, 1999, @mldivide, [], strata, 2);
 %!   stats = bootknife ({X,y}, 1999, @mldivide, [.05,.95], strata);
+%!   stats = bootknife (y, [1999,0.05], @mean, .1, strata, 2);
+%!   stats = bootknife ({x,y}, [1999,0.05], @cor, [.05,.95], strata);
 %! catch
 %!   warning ('on', 'bootknife:parallel')
 %!   rethrow (lasterror)
 %! end
 %! warning ('on', 'bootknife:parallel')
 
+%!test
+%! % Test adaptive NBOOT: resampling stops after the first batch of 499
+%! % resamples when the tolerance is easily met, and runs to NBOOT when it
+%! % cannot be met
+%! y = [183, 192, 182, 183, 177, 185, 188, 188, 182, 185].';
+%! for alpha = {0.05, [0.025, 0.975]}
+%!   [stats, bootstat] = bootknife (y, [19999, 0.5], @mean, alpha{1});
+%!   assert (size (bootstat, 2), 499);
+%!   [stats, bootstat, bootsam] = bootknife (y, [1999, 1e-06], @mean, alpha{1});
+%!   assert (size (bootstat, 2), 1999);
+%!   assert (size (bootsam), [10, 1999]);
+%!   assert (bootstat, mean (y(bootsam)), 1e-09);
+%! end
+
 %!test
 %! % Air conditioning failure times in Table 1.2 of Davison A.C. and
 %! % Hinkley D.V (1997) Bootstrap Methods And Their Application. (Cambridge
@@ -1699,3 +2227,74 @@ end
 %!   assert (stats.CI_upper, 0.945020625755707, 1e-08);
 %! end
 %! % Exact intervals based on normal theory are 0.51 - 0.91
+
+%!function T = stopmean (x)
+%!  % Vectorized mean that raises an error after a set number of calls
+%!  global STOPMEAN_CALLS
+%!  STOPMEAN_CALLS = STOPMEAN_CALLS - 1;
+%!  if (STOPMEAN_CALLS < 0)
+%!    error ('stopmean: Interrupted')
+%!  end
+%!  T = mean (x);
+%!endfunction
+
+%!test
+%! % Test that an interrupted double bootstrap resumes from the CHECKPOINT
+%! % file exactly where it left off (with either the boot MEX file or m-file)
+%! global STOPMEAN_CALLS
+%! x = [48 36 20 29 42 42 20 42 22 41 45 14 6 ...
+%!      0 33 28 34 4 32 24 47 41 24 26 30 41]';
+%! bootsam = boot (26, 199, true, 1);
+%! chkfile = cat (2, tempname (), '.mat');
+%! % Uninterrupted run
+%! rand ('twister', 1);
+%! STOPMEAN_CALLS = Inf;
+%! S1 = bootknife (x, [199, 49], @stopmean, [.05, .95], [], 0, bootsam, ...
+%!                 [], [], [], [], chkfile);
+%! assert (exist (chkfile, 'file'), 0);
+%! % Interrupted run
+%! rand ('twister', 1);
+%! STOPMEAN_CALLS = 20;
+%! try
+%!   bootknife (x, [199, 49], @stopmean, [.05, .95], [], 0, bootsam, ...
+%!              [], [], [], [], chkfile);
+%! end
+%! chkpt = load (chkfile);
+%! assert ((chkpt.done > 0) && (chkpt.done < 199));
+%! % Resumed run (the state of the random number generator is not used)
+%! rand ('twister', 2);
+%! STOPMEAN_CALLS = Inf;
+%! S2 = bootknife (x, [199, 49], @stopmean, [.05, .95], [], 0, [], ...
+%!                 [], [], [], [], chkfile);
+%! assert (S2, S1);
+%! assert (exist (chkfile, 'file'), 0);
+%! % A CHECKPOINT file of different DATA, NBOOT or BOOTFUN is rejected
+%! rand ('twister', 1);
+%! STOPMEAN_CALLS = 20;
+%! try
+%!   bootknife (x, [199, 49], @stopmean, [.05, .95], [], 0, bootsam, ...
+%!              [], [], [], [], chkfile);
+%! end
+%! STOPMEAN_CALLS = Inf;
+%! msg = 'bootknife: The CHECKPOINT file does not match';
+%! err = 0;
+%! try
+%!   bootknife (flipud (x) + 1, [199, 49], @stopmean, [.05, .95], [], 0, ...
+%!              [], [], [], [], [], chkfile);
+%! catch e
+%!   err = err + strncmp (e.message, msg, numel (msg));
+%! end
+%! try
+%!   bootknife (x, [99, 49], @stopmean, [.05, .95], [], 0, [], ...
+%!              [], [], [], [], chkfile);
+%! catch e
+%!   err = err + strncmp (e.message, msg, numel (msg));
+%! end
+%! try
+%!   bootknife (x, [199, 49], @mean, [.05, .95], [], 0, [], ...
+%!              [], [], [], [], chkfile);
+%! catch e
+%!   err = err + strncmp (e.message, msg, numel (msg));
+%! end
+%! assert (err, 3);
+%! delete (chkfile);
@@ -19,11 +19,13 @@
 % -- Function File: bootlm (Y, GROUP, ..., 'blocksz', BLOCKSZ)
 % -- Function File: bootlm (Y, GROUP, ..., 'posthoc', POSTHOC)
 % -- Function File: bootlm (Y, GROUP, ..., 'seed', SEED)
+% -- Function File: bootlm (Y, GROUP, ..., 'profile', PROFOPT)
 % -- Function File: STATS = bootlm (...)
 % -- Function File: [STATS, BOOTSTAT] = bootlm (...)
 % -- Function File: [STATS, BOOTSTAT, AOVSTAT] = bootlm (...)
 % -- Function File: [STATS, BOOTSTAT, AOVSTAT, PRED_ERR] = bootlm (...)
 % -- Function File: [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, X] = bootlm (...)
+% -- Function File: [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, X, PROFILE] = bootlm (...)
 %
 %        Fits a linear model with categorical and/or continuous predictors (i.e.
 %     independent variables) on a continuous outcome (i.e. dependent variable)
@@ -298,6 +300,8 @@
 %
 %       <> Specifies the number of bootstrap resamples, where NBOOT must be a
 %          positive integer. If empty, the default value of NBOOT is 9999.
+%          (Unlike bootwild and bootbayes, bootlm does not accept a pair
+%          [NBOOT, TOL] to set NBOOT adaptively.)
 %
 %     '[...] = bootlm (Y, GROUP, ..., 'clustid', CLUSTID)'
 %
@@ -382,6 +386,14 @@
 %     Twister random number generator using an integer SEED value so that
 %     'bootlm' results are reproducible.
 %
+%     '[...] = bootlm (Y, GROUP, ..., 'profile', PROFOPT)'
+%
+%       <> PROFOPT can be either 'on' (or true) or 'off' (or false, default).
+%          If PROFOPT is 'on', the wall time and the increase in peak memory
+%          of each stage of the computations (and of each nested model for
+%          the prediction errors) are recorded and printed as a table (see
+%          PROFILE below) after the other output.
+%
 %     'bootlm' can return up to four output arguments:
 %
 %     'STATS = bootlm (...)' returns a structure with the following fields:
@@ -457,7 +469,7 @@
 %          sample sizes are equal or not.
 %
 %     '[STATS, BOOTSTAT, AOVSTAT, PRED_ERR] = bootlm (...)' also computes
-%     refined bootstrap estimates of prediction error* and returns statistics
+%     refined bootstrap estimates of prediction error and returns statistics
 %     derived from it in a structure containing the following fields:
 %       - 'MODEL': The formula of the linear model(s) in Wilkinson's notation
 %       - 'PE': Bootstrap estimate of prediction error [5]
@@ -476,15 +488,37 @@
 %        options. Note that it is possible (and not unusual) to get a negative
 %       value for RSQ-pred, particularly for the intercept-only model.
 %
-%     * If the parallel computing toolbox (Matlab) or package (Octave) is
-%       installed and loaded, then these computations will be automatically
-%       accelerated by parallel processing on platforms with multiple processors
-%
 %     '[STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (...)' also returns
 %     a structure containing the design matrix of the predictors (X), the
 %     regression coefficients (b), the hypothesis matrix (L) and the outcome (Y)
 %     for the linear model.
 %
+%     '[STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT, PROFILE] = bootlm (...)' also
+%     records the wall time and the increase in peak memory of each stage of
+%     the computations and returns them in a structure with the following
+%     fields:
+%       - 'STAGE': The names of the stages, in the order they were first run:
+%                  'validation' (of the input arguments), 'design' (design
+%                  matrix, its factorization and the model fit), 'contrasts'
+%                  (estimated marginal means and posthoc contrasts),
+%                  'bootstrap' (bootwild or bootbayes), 'anova' (bootanova),
+%                  'prediction error' (booterr), 'intervals' (interval, p-value
+%                  and effect size computations) and 'display'
+%       - 'TIME': The wall time (in seconds) of each stage
+%       - 'PEAK_MB': The increase in peak (resident) memory, in MB, during
+%                  each stage
+%       - 'TOTAL': The total wall time (in seconds)
+%       - 'MODEL': The formula of each of the nested models for which the
+%                  prediction error was computed
+%       - 'MODEL_TIME' and 'MODEL_PEAK_MB': The wall time and increase in peak
+%                  memory of the prediction error computations for each of the
+%                  nested models
+%
+%       Peak memory can only be measured on Linux, and is NaN elsewhere. Use
+%       the 'profile' option to print the table without requesting all of the
+%       other outputs, since requesting AOVSTAT and PRED_ERR adds the 'anova'
+%       and 'prediction error' stages.
+%
 %  Bibliography:
 %  [1] Penn, A.C. statistics-resampling manual: `bootwild` function reference.
 %        https://gnu-octave.github.io/statistics-resampling/function/bootwild.html 
@@ -503,7 +537,7 @@
 %        Information Criteria and Statistical Modeling. Springer Series in
 %        Statistics. Springer, NY.
 %
-%  bootlm (version 2024.07.08)
+%  bootlm (version 2026.10.17)
 %  Author: Andrew Charles Penn
 %  https://www.researchgate.net/profile/Andrew_Penn/
 %
@@ -521,13 +555,13 @@
 %  You should have received a copy of the GNU General Public License
 %  along with this program.  If not, see http://www.gnu.org/licenses/
 
-function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
+function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT, PROFILE] = bootlm (Y, GROUP, varargin)
 
     if (nargin < 2)
       error (cat (2, 'bootlm usage: ''bootlm (Y, GROUP)''; ', ...
                      ' atleast 2 input arguments required'))
     end
-    if (nargout > 5)
+    if (nargout > 6)
       error ('bootlm: Too many output arguments')
     end
 
@@ -572,6 +606,7 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
     STANDARDIZE = false;
     METHOD = 'wild';
     PRIOR = 1;
+    PROFOPT = 'off';
     L = [];
     STATS = [];
     BOOTSTAT = [];
@@ -619,13 +654,31 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
           PRIOR = value;
         case 'seed'
           SEED = value;
+        case 'profile'
+          PROFOPT = value;
         otherwise
           error ('bootlm: parameter %s is not supported', name)
       end
     end
 
+    % If requested, start profiling the stages of the computations
+    switch (lower (PROFOPT))
+      case {'on', true}
+        PROFOPT = true;
+      case {'off', false}
+        PROFOPT = false;
+      otherwise
+        error ('bootlm: wrong value for ''profile'' parameter.')
+    end
+    prof = profstart (PROFOPT || (nargout > 5));
+
     % Most error checking for NBOOT, ALPHA and SEED is handled by the functions
-    % bootwild and bootbayes
+    % bootwild and bootbayes. The adaptive [NBOOT, TOL] form accepted by those
+    % functions is not supported here, since the ANOVA, prediction errors and
+    % posterior distributions for multiple priors all need NBOOT resamples.
+    if (numel (NBOOT) > 1)
+      error ('bootlm: NBOOT must be a scalar')
+    end
     if (size (ALPHA,1) > 1)
       ALPHA = ALPHA.';
     end
@@ -946,6 +999,8 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
       Y = (Y - mean (Y)) / std (Y);
     end
 
+    prof = profmark (prof, 'validation');
+
     % Create design matrix
     [X, grpnames, nlevels, df, coeffnames, gid, CONTRASTS, ...
      center_continuous] = mDesignMatrix (GROUP, TERMS, CONTINUOUS, ...
@@ -972,9 +1027,14 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
       L = unique_stable (H, 'rows')';
     end
 
-    % Fit linear model
+    % Fit linear model. The design matrix is factorized just once here and the
+    % factorization is reused by all of the bootstrap computations below that
+    % involve the same design (i.e. bootwild, bootanova and booterr)
     X = cell2mat (X);
-    [b, sse, resid, ucov, hat] = lmfit (X, Y, ISOCTAVE);
+    FACTORS = factorize (X, cumsum (cat (1, 1, df)));
+    b = FACTORS.pinv * Y;
+    resid = Y - X * b;                           % Residuals from the fit
+    sse = sum (resid.^2);                        % Residual sum-of-squares
 
     % Prepare model formula
     TERMNAMES = arrayfun (@(i) sprintf (':%s', VARNAMES{TERMS(i,:)}), ...
@@ -1019,6 +1079,7 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
       end
     end
     N = max (IC);
+    prof = profmark (prof, 'design');
 
     % Use bootstrap methods to calculate statistics
     if isempty (DIM)
@@ -1034,26 +1095,31 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
         case 'wild'
           % Perform regression on full model using the specified contrasts
           [STATS, BOOTSTAT] = bootwild (Y, X, DEP, NBOOT, ALPHA, SEED, [], ...
-                                        ISOCTAVE);
+                                        ISOCTAVE, FACTORS);
+          prof = profmark (prof, 'bootstrap');
           % Create empty fields in STATS structure
           STATS.N = N;
           STATS.prior = [];
           if (nargout > 2)
             % Perform ANOVA
-            AOVSTAT = bootanova (Y, X, cat (1, 1, df), dfe, DEP, NBOOT, NaN, ...
-                                 SEED, ISOCTAVE, PARALLEL);
+            AOVSTAT = bootanova (Y, FACTORS, cat (1, 1, df), dfe, DEP, NBOOT, ...
+                                 SEED);
             AOVSTAT.MODEL = formula;
+            prof = profmark (prof, 'anova');
           end
           if (nargout > 3)
             % Estimate prediction errors
-            PRED_ERR = booterr (Y, X, cat (1, 1, df), n, DEP, NBOOT, NaN, ...
-                                 SEED, ISOCTAVE, PARALLEL);
+            [PRED_ERR, prof] = booterr (Y, FACTORS, cat (1, 1, df), n, DEP, ...
+                                        NBOOT, SEED, prof);
             PRED_ERR.MODEL = cat (1, {sprintf('%s ~ 1',Y_name)}, formula);
+            prof.model = PRED_ERR.MODEL;
+            prof = profmark (prof, 'prediction error');
           end
         case {'bayes', 'bayesian'}
           [STATS, BOOTSTAT] = bootbayes (Y, X, DEP, NBOOT, ...
                                          fliplr (1 - ALPHA), PRIOR, SEED, ...
                                          [], ISOCTAVE);
+          prof = profmark (prof, 'bootstrap');
           % Create empty fields in STATS structure
           STATS.pval = [];
           STATS.fpr = [];
@@ -1129,10 +1195,12 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
 
           % The model estimated marginal means
           pairs = [];
+          prof = profmark (prof, 'contrasts');
           switch (lower (METHOD))
             case 'wild'
               [STATS, BOOTSTAT] = bootwild (Y, X, DEP, NBOOT, ALPHA, SEED, ...
-                                            L, ISOCTAVE);
+                                            L, ISOCTAVE, FACTORS);
+              prof = profmark (prof, 'bootstrap');
               % Create empty fields in STATS structure
               STATS.prior = [];
             case {'bayes', 'bayesian'}
@@ -1145,31 +1213,13 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
                     STATS.prior = PRIOR;
                   else
                     % If the prior is not the same across all the samples then
-                    % we need to perform a separate simulation for each sample.
-                    % Use parallel processing if it is available to accelerate
-                    % bootstrap computation for each column of the hypothesis
-                    % matrix.
-                    if (PARALLEL)
-                      if (ISOCTAVE)
-                        [STATS, BOOTSTAT] = pararrayfun (inf, @(i) bootbayes ( ...
-                                  Y, X, DEP, NBOOT, fliplr (1 - ALPHA), ...
-                                  PRIOR(i), SEED, L(:, i), ISOCTAVE), (1:Np)', ...
-                                  'UniformOutput', false);
-                      else
-                        STATS = cell (Np, 1); BOOTSTAT = cell (Np, 1);
-                        parfor i = 1:Np
-                          [STATS{i}, BOOTSTAT{i}] =  bootbayes (Y, X, DEP, ...
-                                           NBOOT, fliplr (1 - ALPHA), ...
-                                           PRIOR(i), SEED, L(:, i), ISOCTAVE);
-                        end
-                      end
-                    else
-                      [STATS, BOOTSTAT] = arrayfun (@(i) bootbayes (Y, X, ...
-                             DEP, NBOOT, fliplr (1 - ALPHA), PRIOR(i), SEED, ...
-                             L(:, i), ISOCTAVE), (1:Np)', 'UniformOutput', false);
-                    end
-                    STATS = flatten_struct (cell2mat (STATS));
-                    BOOTSTAT = cell2mat (BOOTSTAT);
+                    % we need to perform a separate simulation for each of the
+                    % distinct values of the prior. Columns of the hypothesis
+                    % matrix that share the same prior are evaluated together
+                    % in the same simulation.
+                    [STATS, BOOTSTAT] = bootbayes_multiprior (Y, X, DEP, ...
+                             NBOOT, fliplr (1 - ALPHA), PRIOR, SEED, L, ...
+                             ISOCTAVE, PARALLEL);
                   end
                 otherwise
                   [STATS, BOOTSTAT] = bootbayes (Y, X, DEP, NBOOT, ...
@@ -1177,6 +1227,7 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
                                          L, ISOCTAVE);
                   STATS.prior = PRIOR * ones (Np, 1);
               end
+              prof = profmark (prof, 'bootstrap');
               % Create empty fields in STATS structure
               STATS.pval = [];
               STATS.fpr = [];
@@ -1224,8 +1275,10 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
               % Modifying the hypothesis matrix (L) to perform the desired tests
               L = make_test_matrix (L, pairs);
               Np = size (pairs, 1);    % Update the number of parameters
+              prof = profmark (prof, 'contrasts');
               [STATS, BOOTSTAT] = bootwild (Y, X, DEP, NBOOT, ALPHA, SEED, ...
-                                            L, ISOCTAVE);
+                                            L, ISOCTAVE, FACTORS);
+              prof = profmark (prof, 'bootstrap');
               % Control the type 1 error rate across multiple comparisons
               STATS.pval = holm (STATS.pval);
               % Update minimum false positive risk after multiple comparisons
@@ -1233,6 +1286,7 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
               % Create empty fields in STATS structure
               STATS.prior = [];
             case {'bayes', 'bayesian'}
+              prof = profmark (prof, 'contrasts');
               switch (lower (PRIOR))
                 case 'auto'
                   % To enable the 'auto' prior to be set independently on each
@@ -1247,31 +1301,13 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
                              fliplr (1 - ALPHA), PRIOR(1), SEED, L, ISOCTAVE);
                   else
                     % If the prior is not the same across all the samples then
-                    % we need to perform a separate simulation for each sample.
-                    % Use parallel processing if it is available to accelerate
-                    % bootstrap computation for each column of the hypothesis
-                    % matrix.
-                    if (PARALLEL)
-                      if (ISOCTAVE)
-                        [STATS, BOOTSTAT] = pararrayfun (inf, @(i) bootbayes ( ...
-                                  Y, X, DEP, NBOOT, fliplr (1 - ALPHA), ...
-                                  PRIOR(i), SEED, L(:, i), ISOCTAVE), (1:Np)', ...
-                                  'UniformOutput', false);
-                      else
-                        STATS = cell (Np, 1); BOOTSTAT = cell (Np, 1);
-                        parfor i = 1:Np
-                          [STATS{i}, BOOTSTAT{i}] =  bootbayes (Y, X, DEP, ...
-                                           NBOOT, fliplr (1 - ALPHA), ...
-                                           PRIOR(i), SEED, L(:, i), ISOCTAVE);
-                        end
-                      end
-                    else
-                      [STATS, BOOTSTAT] = arrayfun (@(i) bootbayes (Y, X, ...
-                             DEP, NBOOT, fliplr (1 - ALPHA), PRIOR(i), SEED, ...
-                             L(:, i), ISOCTAVE), (1:Np)', 'UniformOutput', false);
-                    end
-                    STATS = flatten_struct (cell2mat (STATS));
-                    BOOTSTAT = cell2mat (BOOTSTAT);
+                    % we need to perform a separate simulation for each of the
+                    % distinct values of the prior. Columns of the hypothesis
+                    % matrix that share the same prior are evaluated together
+                    % in the same simulation.
+                    [STATS, BOOTSTAT] = bootbayes_multiprior (Y, X, DEP, ...
+                             NBOOT, fliplr (1 - ALPHA), PRIOR, SEED, L, ...
+                             ISOCTAVE, PARALLEL);
                   end
                 otherwise
                   % Compute the posterior distributions for the estimated
@@ -1282,6 +1318,7 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
                                          fliplr (1 - ALPHA), PRIOR, SEED, ...
                                          L, ISOCTAVE);
               end
+              prof = profmark (prof, 'bootstrap');
               % Create empty fields in STATS structure
               STATS.pval = [];
               STATS.fpr = [];
@@ -1407,6 +1444,7 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
     if (nargout > 4)
       MAT = struct ('X', X, 'b', b, 'L', L, 'Y', Y);
     end
+    prof = profmark (prof, 'intervals');
 
     % Print table of model coefficients and make figure of diagnostic plots
     switch (lower (DISPLAY))
@@ -1481,7 +1519,13 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
         % Make figure of diagnostic plots
         fhandle = figure (1);
         set (fhandle, 'Name', 'Diagnostic Plots: Model Residuals');
-        h = diag (hat);                          % Leverage values
+        if (iscell (FACTORS.Q))                  % Orthonormal basis for the
+          Q = FACTORS.Q{end};                    % column space of X (see
+        else                                     % factorize)
+          Q = FACTORS.Q;
+        end
+        h = sum (Q.^2, 2);                       % Leverage values, i.e. the
+                                                 % diagonal of Q * Q'
         mse = sse / dfe;                         % Mean squared error
         t = resid ./ (sqrt (mse * (1 - h)));     % Studentized residuals
         p = n - dfe;                             % Number of parameters
@@ -1577,6 +1621,15 @@ function [STATS, BOOTSTAT, AOVSTAT, PRED_ERR, MAT] = bootlm (Y, GROUP, varargin)
         error ('bootlm: wrong value for ''display'' parameter.')
 
     end
+    prof = profmark (prof, 'display');
+
+    % Return and/or print the profile of the stages of the computations
+    if (prof.on)
+      PROFILE = profreport (prof);
+      if (PROFOPT)
+        printprofile (PROFILE);
+      end
+    end
 
 end
 
@@ -1822,30 +1875,39 @@ end
 
 %--------------------------------------------------------------------------
 
-% FUNCTION TO FIT THE LINEAR MODEL
-
-function [b, sse, resid, ucov, hat] = lmfit (X, Y, ISOCTAVE)
-
-  % Get model coefficients by solving the linear equation. The number of free
-  % parameters (i.e. intercept + coefficients) is equal to n - dfe (i.e. the
-  % number of columns in X).
-  b = pinv (X) * Y;                 % Equivalent to inv (X' * X) * (X' * y);
-
-  % Get fitted values
-  fit = X * b;
-
-  % Get residuals from the fit
-  resid = Y - fit;
-
-  % Calculate the residual sums-of-squares
-  sse = sum (resid.^2);
-
-  % Calculate the unscaled covariance matrix (i.e. inv (X'*X )) and the Hat
-  % matrix (i.e. X*(X'*X)^−1*X') by QR decomposition
-  if (nargout > 3)
-    [Q, R] = qr (X, 0);     % Economy-sized QR decomposition
-    ucov = pinv (R' * R);   % Instead of pinv (X' * X)
-    hat = Q * Q';
+% FUNCTION TO FACTORIZE THE DESIGN MATRIX
+
+function F = factorize (X, NX)
+
+  % Returns a structure containing the Moore-Penrose pseudoinverse of X (pinv),
+  % the unscaled covariance matrix (ucov), i.e. pinv (X' * X), and orthonormal
+  % bases (Q) for the design matrices of the nested models made up of the first
+  % NX(j) columns of X. When X has full column rank, all of these are obtained
+  % from a single economy-sized QR decomposition of X, such that Q(:, 1:NX(j))
+  % spans the column space of X(:, 1:NX(j)). Otherwise, pinv and ucov are
+  % computed from the singular value decomposition of X and Q is a cell array
+  % containing a basis for each nested model, using the same tolerance for rank
+  % determination as pinv.
+  [n, k] = size (X);
+  [Q, R] = qr (X, 0);
+  d = abs (diag (R));
+  F = struct ('pinv', [], 'ucov', [], 'Q', [], 'NX', NX);
+  if ( (n >= k) && all (d > max (n, k) * max (d) * eps) )
+    F.pinv = R \ Q';
+    F.ucov = R \ (R' \ eye (k));
+    F.Q = Q;
+  else
+    [U, S, V] = svd (X, 0);
+    s = diag (S);
+    i = s > max (n, k) * max (s) * eps;
+    F.pinv = V(:, i) * diag (1 ./ s(i)) * U(:, i)';
+    F.ucov = V(:, i) * diag (1 ./ s(i).^2) * V(:, i)';
+    F.Q = cell (numel (NX), 1);
+    for j = 1:numel (NX)
+      [U, S] = svd (X(:, 1:NX(j)), 0);
+      s = diag (S);
+      F.Q{j} = U(:, s > max (n, NX(j)) * max (s) * eps);
+    end
   end
 
 end
@@ -1940,15 +2002,53 @@ end
 
 %--------------------------------------------------------------------------
 
-% FUNCTION TO FLATTEN A STRUCTURE ARRAY
+% FUNCTION TO PERFORM BAYESIAN BOOTSTRAP WITH A PRIOR FOR EACH CONTRAST
 
-function F = flatten_struct (S)
+function [STATS, BOOTSTAT] = bootbayes_multiprior (Y, X, DEP, NBOOT, PROB, ...
+                                            PRIOR, SEED, L, ISOCTAVE, PARALLEL)
 
-  fn = fieldnames (S);
-  nm = numel (fn);
-  F = struct;
-  for i = 1:nm
-    F.(fn{i}) = [S.(fn{i})]';
+  % Columns of the hypothesis matrix (L) are grouped by the value of their
+  % PRIOR and a single bootbayes simulation is run for each group. Since the
+  % random seed is reset at the start of each simulation, the results for each
+  % column of L are identical to those of a separate simulation for each
+  % column, but the gamma draws and the weighted regressions for each bootstrap
+  % replicate are shared by all columns of L that have the same prior.
+  Np = size (L, 2);
+  [UP, jnk, IP] = unique (PRIOR(:));
+  Ng = numel (UP);
+
+  % Use parallel processing if it is available to accelerate bootstrap
+  % computation for each of the groups
+  if (PARALLEL)
+    if (ISOCTAVE)
+      [S, B] = pararrayfun (inf, @(g) bootbayes (Y, X, DEP, NBOOT, PROB, ...
+                            UP(g), SEED, L(:, IP == g), ISOCTAVE), (1:Ng)', ...
+                            'UniformOutput', false);
+    else
+      S = cell (Ng, 1); B = cell (Ng, 1);
+      parfor g = 1:Ng
+        [S{g}, B{g}] =  bootbayes (Y, X, DEP, NBOOT, PROB, UP(g), SEED, ...
+                                   L(:, IP == g), ISOCTAVE);
+      end
+    end
+  else
+    [S, B] = arrayfun (@(g) bootbayes (Y, X, DEP, NBOOT, PROB, UP(g), ...
+                       SEED, L(:, IP == g), ISOCTAVE), (1:Ng)', ...
+                       'UniformOutput', false);
+  end
+
+  % Return the statistics in the same order as the columns of L
+  fn = fieldnames (S{1});
+  STATS = struct;
+  for i = 1:numel (fn)
+    STATS.(fn{i}) = nan (Np, 1);
+    for g = 1:Ng
+      STATS.(fn{i})(IP == g, 1) = S{g}.(fn{i});
+    end
+  end
+  BOOTSTAT = zeros (Np, NBOOT);
+  for g = 1:Ng
+    BOOTSTAT(IP == g, :) = B{g};
   end
 
 end
@@ -2041,18 +2141,23 @@ end
 
 % FUNCTION TO PERFORM ANOVA
 
-function AOVSTAT = bootanova (Y, X, DF, DFE, DEP, NBOOT, ALPHA, SEED, ...
-                              ISOCTAVE, PARALLEL)
+function AOVSTAT = bootanova (Y, FACTORS, DF, DFE, DEP, NBOOT, SEED)
 
   % Bootstrap ANOVA (using sequential sums-of-squares, a.k.a. Type 1)
 
-  % Compute observed statistics
+  % Since the models being compared are nested (i.e. the design matrix of each
+  % model is made up of the first sum (DF(1:j)) columns of X), the sequential
+  % sums-of-squares for all of the models are obtained from the factorization
+  % of the design matrix of the full model (see factorize).
   Nt = numel (DF) - 1;
-  [jnk, SSE, RESID] = arrayfun (@(j) lmfit (X(:,1:sum (DF(1:j))), Y, ...
-                                ISOCTAVE), (1:Nt + 1)', 'UniformOutput', false);
-  SS = max (-diff (cell2mat (SSE)), 0);
+  NX = FACTORS.NX;
+  Q = FACTORS.Q;
+
+  % Compute observed statistics
+  [SSE, RESID] = nestedsse (Y, Q, NX);
+  SS = max (-diff (SSE), 0);
   MS = SS ./ DF(2:end);
-  MSE = SSE{end} / DFE;
+  MSE = SSE(end) / DFE;
   F = MS / MSE;
 
   % Obtain the F distribution under the null hypothesis by bootstrap of the
@@ -2061,29 +2166,25 @@ function AOVSTAT = bootanova (Y, X, DF, DFE, DEP, NBOOT, ALPHA, SEED, ...
   % et al (Eds.) Bootstrapping and Related Techniques. Springer-Verlag, Berlin,
   % pg 79-86
   % See also the R function: https://rdrr.io/cran/lmboot/src/R/ANOVA.boot.R
-  % Use parallel processing if it is available to accelerate bootstrap
-  % computation of stepwise regression.
-  if (PARALLEL)
-    if (ISOCTAVE)
-      [jnk, BOOTSTAT, BOOTSSE] = pararrayfun (inf, @(j) bootwild ( ...
-                                    RESID{end}, X(:, 1:sum (DF(1:j))), ...
-                                    DEP, NBOOT, ALPHA, SEED, [], ISOCTAVE), ...
-                                    (1:Nt + 1)', 'UniformOutput', false);
+  % The residuals of the full model are orthogonal to the design matrices of
+  % all the nested models, so the wild bootstrap resamples of the residuals
+  % are the same for all of the models. The resamples are therefore generated
+  % just once (using the same multipliers as bootwild) and the bootstrap sums-
+  % of-squared error of all the nested models are computed in blocks of
+  % bootstrap resamples. The multipliers are generated one block at a time.
+  [G, IC] = wildclust (DEP, numel (Y));
+  rand ('seed', SEED);
+  BOOTSSE = zeros (Nt + 1, NBOOT);
+  blksz = max (1, fix (1e+07 / numel (Y)));
+  for b = 1:blksz:NBOOT
+    idx = b:min (b + blksz - 1, NBOOT);
+    S = wildmult (G, numel (idx));
+    if (isempty (IC))
+      BOOTSSE(:, idx) = nestedsse (bsxfun (@times, RESID, S), Q, NX);
     else
-      BOOTSTAT = cell (Nt + 1, 1); BOOTSSE = cell (Nt + 1, 1);
-      parfor j = 1:Nt + 1
-        [jnk, BOOTSTAT{j}, BOOTSSE{j}] = bootwild (RESID{end}, ...
-                                     X(:, 1:sum (DF(1:j))), DEP, NBOOT,...
-                                     ALPHA, SEED, [], ISOCTAVE);
-      end
+      BOOTSSE(:, idx) = nestedsse (bsxfun (@times, RESID, S(IC, :)), Q, NX);
     end
-  else
-    [jnk, BOOTSTAT, BOOTSSE] = arrayfun (@(j) bootwild ( RESID{end}, ...
-                                  X(:, 1:sum (DF(1:j))), DEP, NBOOT, ALPHA, ...
-                                  SEED, [], ISOCTAVE), (1:Nt + 1)', ...
-                                  'UniformOutput', false);
   end
-  BOOTSSE = cell2mat (BOOTSSE);
   BOOTSS = max (-diff (BOOTSSE), 0);
   BOOTMS = bsxfun (@rdivide, BOOTSS, DF(2:end));
   BOOTMSE = BOOTSSE(end,:) / DFE;
@@ -2106,56 +2207,142 @@ function AOVSTAT = bootanova (Y, X, DF, DFE, DEP, NBOOT, ALPHA, SEED, ...
 
   % Prepare output
   AOVSTAT = struct ('MODEL', [], 'SS', SS, 'DF', DF(2:end), 'MS', MS, 'F', ...
-                     F, 'PVAL', PVAL, 'FPR', FPR, 'SSE', SSE{end}, ...
+                     F, 'PVAL', PVAL, 'FPR', FPR, 'SSE', SSE(end), ...
                     'DFE', DFE, 'MSE', MSE);
 
 end
 
 %--------------------------------------------------------------------------
 
+% FUNCTION TO COMPUTE THE RESIDUAL SUMS-OF-SQUARES OF NESTED MODELS
+
+function [SSE, RESID] = nestedsse (Y, Q, P)
+
+  % Each column of Y is regressed on the design matrices of all the nested
+  % models (see factorize). SSE is a matrix of the residual sums-of-squares
+  % with a row for each nested model and a column for each column of Y. RESID
+  % are the residuals of the full (i.e. last) model.
+  if (iscell (Q))
+    SSE = zeros (numel (P), size (Y, 2));
+    for j = 1:numel (P)
+      RESID = Y - Q{j} * (Q{j}' * Y);
+      SSE(j, :) = sum (RESID.^2, 1);
+    end
+  else
+    % The columns of Q that are not in a nested model each contribute the
+    % square of their projection of Y to the residual sum-of-squares
+    Z = Q' * Y;
+    RESID = Y - Q * Z;
+    C = cat (1, flipud (cumsum (flipud (Z.^2), 1)), zeros (1, size (Y, 2)));
+    SSE = bsxfun (@plus, sum (RESID.^2, 1), C(P + 1, :));
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+% FUNCTIONS TO GENERATE THE MULTIPLIERS FOR WILD BOOTSTRAP
+
+function [G, IC] = wildclust (DEP, n)
+
+  % Returns the number of clusters (G) and, for wild cluster or block
+  % bootstrap, the vector IC that maps each of the n observations to one of
+  % the G clusters. The cluster indices are identical to those used by
+  % bootwild.
+  if (isempty (DEP))
+    G = n;
+    IC = [];
+  elseif (isscalar (DEP))
+    G = fix (n / DEP);
+    IC = (G + 1) * ones (n, 1);
+    IC(1 : DEP * G, :) = reshape (ones (DEP, 1) * (1:G), [], 1);
+    G = IC(end);
+  else
+    [C, IA, IC] = unique (DEP);
+    G = numel (C);
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function S = wildmult (G, NB)
+
+  % Returns a G-by-NB block of random multipliers from Webb's 6-point
+  % distribution. bootwild generates its multipliers in the same way, one block
+  % of (at most) fix (1e+07 / n) resamples at a time, so the multipliers are
+  % identical to those of bootwild when the random number generator is set
+  % with the same SEED and the blocks are the same size.
+  S = sign (rand (G, NB) - 0.5) .* sqrt (0.5 * (fix (rand (G, NB) * 3) + 1));
+
+end
+
+%--------------------------------------------------------------------------
+
 % FUNCTION TO ESTIMATE PREDICTION ERRORS
 
-function PRED_ERR = booterr (Y, X, DF, n, DEP, NBOOT, ALPHA, SEED, ...
-                             ISOCTAVE, PARALLEL)
+function [PRED_ERR, prof] = booterr (Y, FACTORS, DF, n, DEP, NBOOT, SEED, prof)
 
-  % Refined bootstrap estimates of prediction error of linear models
+  % Refined bootstrap estimates of prediction error of linear models. If
+  % profiling, the wall time and peak memory for each nested model are
+  % recorded in prof (see profmodel).
 
-  % Compute observed statistics
+  % Use the factorization of the design matrices of the nested models (see
+  % factorize)
   Nt = numel (DF) - 1;
-  [jnk, RSS] = arrayfun (@(j) lmfit (X(:,1:sum (DF(1:j))), Y, ISOCTAVE), ...
-                                     (1:Nt + 1)', 'UniformOutput', false);
+  NX = FACTORS.NX;
+  Q = FACTORS.Q;
+
+  % Compute observed statistics
+  RSS = nestedsse (Y, Q, NX);
 
   % Compute refined bootstrap estimates of prediction error (PE)
   % See Efron and Tibshirani (1993) An Introduction to the Bootstrap. pg 247-252
-  % Use parallel processing if it is available to accelerate bootstrap
-  % computation of stepwise regression.
-  if (PARALLEL)
-    if (ISOCTAVE)
-      [jnk, jnk, BOOTRSS, BOOTFIT] = pararrayfun (inf, @(j) bootwild ( ...
-                                    Y, X(:, 1:sum (DF(1:j))), DEP,  ...
-                                    NBOOT, ALPHA, SEED, [], ISOCTAVE), ...
-                                    (1:Nt + 1)', 'UniformOutput', false);
+  % For each model, the wild bootstrap resamples are Y* = fit + r .* s, where
+  % fit and r are the fitted values and residuals of the model, and s are the
+  % multipliers (identical to those used by bootwild). If U is an orthonormal
+  % basis for the design matrix of the model and z = U' * (r .* s), the sum-of-
+  % squared error of the fit to each resample and the sum of squared errors of
+  % the original data around the fit to each resample are:
+  %   sum ((Y* - U * U' * Y*).^2) = sum ((r .* s).^2) - sum (z.^2)
+  %   sum ((Y - U * U' * Y*).^2)  = sum (r.^2) - 2 * (U' * r)' * z + sum (z.^2)
+  % The products with r .* s are accumulated within each cluster, so these 
+  % sums are obtained without forming the resampled or fitted values. Rather
+  % than storing the multipliers for all of the resamples, they are generated
+  % one block at a time, from the same SEED for each of the models.
+  [G, IC] = wildclust (DEP, n);
+  if (isempty (IC))
+    M = 1;
+  else
+    M = sparse (IC, (1:n)', 1, max (IC), n);
+  end
+  S_ERR = zeros (Nt + 1, NBOOT);
+  A_ERR = zeros (Nt + 1, NBOOT);
+  blksz = max (1, fix (1e+07 / n));
+  prof = profmodel (prof, 0);
+  for j = 1:Nt + 1
+    if (iscell (Q))
+      U = Q{j};
     else
-      BOOTRSS = cell (Nt + 1, 1); BOOTFIT = cell (Nt + 1, 1);
-      parfor j = 1:Nt + 1
-        [jnk, jnk, BOOTRSS{j}, BOOTFIT{j}] = bootwild (Y, ...
-                                         X(:, 1:sum (DF(1:j))), DEP, NBOOT, ...
-                                         ALPHA, SEED, [], ISOCTAVE);
-                                     
-      end
+      U = Q(:, 1:NX(j));
     end
-  else
-    [jnk, jnk, BOOTRSS, BOOTFIT] = arrayfun (@(j) bootwild ( ...
-                                  Y, X(:, 1:sum (DF(1:j))), ...
-                                  DEP, NBOOT, ALPHA, SEED, [], ISOCTAVE), ...
-                                  (1:Nt + 1)', 'UniformOutput', false);
+    r = Y - U * (U' * Y);
+    A = M * bsxfun (@times, U, r);
+    r2 = M * r.^2;
+    w = U' * r;
+    rand ('seed', SEED);
+    for b = 1:blksz:NBOOT
+      idx = b:min (b + blksz - 1, NBOOT);
+      S = wildmult (G, numel (idx));
+      Z = A' * S;
+      ZZ = sum (Z.^2, 1);
+      A_ERR(j, idx) = (r2' * S.^2 - ZZ) / n;
+      S_ERR(j, idx) = (sum (r.^2) - 2 * w' * Z + ZZ) / n;
+    end
+    prof = profmodel (prof, j);
   end
-  S_ERR = cell2mat (arrayfun (@(j) sum (bsxfun (@minus, Y, ...
-                    BOOTFIT{j}).^2, 1) / n, (1:Nt + 1)', ...
-                    'UniformOutput', false)); % Simple estimate of error
-  A_ERR = cell2mat (BOOTRSS) / n;             % Apparent error in resamples
   OPTIM = S_ERR - A_ERR;                      % Optimism in apparent error
-  PE = cell2mat (RSS) / n + sum (OPTIM, 2) / NBOOT;
+  PE = RSS / n + sum (OPTIM, 2) / NBOOT;
 
   % Compute the Extended (Efron) Information Criterion, weights and relative
   % liklihood. Uses simplified formula to calculate the log-likelihood from the
@@ -2167,7 +2354,7 @@ function PRED_ERR = booterr (Y, X, DF, n, DEP, NBOOT, ALPHA, SEED, ...
   S_LL = LogLik (S_ERR);            % Simple estimate of expected log-likelihood
   A_LL = LogLik (A_ERR);            % Apparent estimates of log-likelihood
   b = sum (A_LL - S_LL, 2) / NBOOT; % Bootstrap bias estimate of log-likelihood
-  LL = LogLik (cell2mat (RSS) / n); % Log-likelihood of model on original sample
+  LL = LogLik (RSS / n);            % Log-likelihood of model on original sample
   EIC = -2 * LL + 2 * b;            % Extended (Efron) Information Criterion
   RL = exp (0.5 * (EIC(1) - EIC));  % Relative likelihood compared to intercept-
                                     % only model: exp (0.5 * (EIC[H0] - EIC[H1]))
@@ -2176,7 +2363,7 @@ function PRED_ERR = booterr (Y, X, DF, n, DEP, NBOOT, ALPHA, SEED, ...
   % Transform prediction errors to predicted R-squared statistics
   PRESS = PE * n;                             % Bootstrap estimate of predicted 
                                               % residual error sum of squares
-  SST = RSS{1};                               % Total sum of squares
+  SST = RSS(1);                               % Total sum of squares
   PE_RSQ = 1 - PRESS / SST;                   % Predicted R-squared calculated 
                                               % by refined bootstrap
 
@@ -2186,6 +2373,119 @@ function PRED_ERR = booterr (Y, X, DF, n, DEP, NBOOT, ALPHA, SEED, ...
 
 end
 
+%--------------------------------------------------------------------------
+
+% FUNCTIONS TO PROFILE THE STAGES OF THE COMPUTATIONS
+
+function prof = profstart (on)
+
+  % Returns a structure for recording the wall time and the increase in peak
+  % (resident) memory of each stage of the computations, which are marked by
+  % calls to profmark. If on is false, profmark and profmodel do nothing.
+  prof = struct ('on', on, 'stage', {{}}, 'time', [], 'peak_mb', [], ...
+                 'model', {{}}, 'model_time', [], 'model_peak_mb', [], ...
+                 'peak', 0, 'rss', NaN, 'mrss', NaN, 't0', [], 't', [], ...
+                 'tm', []);
+  if (on)
+    prof.rss = resetpeak ();
+    prof.t0 = tic;
+    prof.t = tic;
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function prof = profmark (prof, name)
+
+  % Records the wall time and increase in peak memory since the previous mark
+  % as the stage called name (adding to any previous record of that stage) 
+  if (~ prof.on)
+    return
+  end
+  t = toc (prof.t);
+  peak = max ([prof.peak, (procstatus ('VmHWM') - prof.rss) / 1024, 0]);
+  i = find (strcmp (prof.stage, name));
+  if (isempty (i))
+    prof.stage{end + 1, 1} = name;
+    prof.time(end + 1, 1) = t;
+    prof.peak_mb(end + 1, 1) = peak;
+  else
+    prof.time(i) = prof.time(i) + t;
+    prof.peak_mb(i) = max (prof.peak_mb(i), peak);
+  end
+  prof.peak = 0;
+  prof.rss = resetpeak ();
+  prof.t = tic;
+
+end
+
+%--------------------------------------------------------------------------
+
+function prof = profmodel (prof, j)
+
+  % Records the wall time and increase in peak memory since the previous call
+  % for nested model j (or, if j is 0, starts timing the first model). The
+  % peak memory of the current stage is retained, since measuring the peak
+  % memory of each model resets it.
+  if (~ prof.on)
+    return
+  end
+  prof.peak = max ([prof.peak, (procstatus ('VmHWM') - prof.rss) / 1024]);
+  if (j > 0)
+    prof.model_time(j, 1) = toc (prof.tm);
+    prof.model_peak_mb(j, 1) = max ((procstatus ('VmHWM') - prof.mrss) / ...
+                                    1024, 0);
+  end
+  prof.mrss = resetpeak ();
+  prof.tm = tic;
+
+end
+
+%--------------------------------------------------------------------------
+
+function PROFILE = profreport (prof)
+
+  % Prepare the PROFILE output from the record of the stages
+  PROFILE = struct ('STAGE', {prof.stage}, 'TIME', prof.time, ...
+                    'PEAK_MB', prof.peak_mb, 'TOTAL', toc (prof.t0), ...
+                    'MODEL', {prof.model}, 'MODEL_TIME', prof.model_time, ...
+                    'MODEL_PEAK_MB', prof.model_peak_mb);
+
+end
+
+%--------------------------------------------------------------------------
+
+function printprofile (PROFILE)
+
+  % Print the PROFILE output as a table
+  fprintf ('\nPROFILE (wall time and increase in peak memory)\n\n');
+  fprintf (cat (2, 'stage                                  time (s)', ...
+                   '     %%      peak (MB)\n'));
+  fprintf (cat (2, '--------------------------------------------', ...
+                   '------------------------------------\n'));
+  for i = 1:numel (PROFILE.STAGE)
+    fprintf ('%-37s  %10.4g  %6.1f  %10.1f\n', PROFILE.STAGE{i}, ...
+             PROFILE.TIME(i), 100 * PROFILE.TIME(i) / PROFILE.TOTAL, ...
+             PROFILE.PEAK_MB(i));
+  end
+  fprintf ('%-37s  %10.4g\n', 'total', PROFILE.TOTAL);
+  if (~ isempty (PROFILE.MODEL_TIME))
+    fprintf ('\nPREDICTION ERROR BY NESTED MODEL\n\n');
+    fprintf (cat (2, 'model                                  time (s)', ...
+                     '             peak (MB)\n'));
+    fprintf (cat (2, '--------------------------------------------', ...
+                     '------------------------------------\n'));
+    for j = 1:numel (PROFILE.MODEL_TIME)
+      fprintf ('%-37s  %10.4g          %10.1f\n', ...
+               PROFILE.MODEL{j}(1:min(end,37)), PROFILE.MODEL_TIME(j), ...
+               PROFILE.MODEL_PEAK_MB(j));
+    end
+  end
+  fprintf('\n');
+
+end
+
 %--------------------------------------------------------------------------
 %!demo
 %!
@@ -3423,3 +3723,28 @@ end
 %!                                      'display', 'off');
 %! 
 %! assert (aovstat.PVAL, 0.001343607345983057, 1e-09);
+
+%!test
+%! % Test the profile of the stages of the computations
+%! y = [23 44 36 22 36 28 24 34 38 41 31 29]';
+%! g = {'A' 'A' 'A' 'A' 'B' 'B' 'B' 'B' 'C' 'C' 'C' 'C'}';
+%! [stats1, bootstat1] = bootlm (y, g, 'seed', 1, 'display', 'off');
+%! [stats2, bootstat2, aovstat, pred_err, mat, profile] = bootlm (y, g, ...
+%!                                     'seed', 1, 'display', 'off');
+%! assert (stats1, stats2);
+%! assert (bootstat1, bootstat2);
+%! assert (profile.STAGE, {'validation'; 'design'; 'bootstrap'; 'anova'; ...
+%!                         'prediction error'; 'intervals'; 'display'});
+%! assert (all (profile.TIME >= 0));
+%! assert (sum (profile.TIME) <= profile.TOTAL);
+%! assert (profile.MODEL, pred_err.MODEL);
+%! assert (numel (profile.MODEL_TIME), 2);
+%!
+%! % Test the stages of the posthoc comparisons
+%! for method = {'wild', 'bayesian'}
+%!   [stats, bootstat, aovstat, pred_err, mat, profile] = bootlm (y, g, ...
+%!                'dim', 1, 'posthoc', 'pairwise', 'method', method{1}, ...
+%!                'seed', 1, 'display', 'off');
+%!   assert (profile.STAGE, {'validation'; 'design'; 'contrasts'; ...
+%!                           'bootstrap'; 'intervals'; 'display'});
+%! end
@@ -0,0 +1,156 @@
+% Merges the bootstrap statistics and resamples from the shards of a bootstrap
+% that was split across several independent runs of the 'bootstrp' function.
+%
+% -- Function File: BOOTSTAT = bootmerge (FILES)
+% -- Function File: [BOOTSTAT, BOOTSAM] = bootmerge (FILES)
+% -- Function File: [BOOTSTAT, BOOTSAM, STATS] = bootmerge (FILES)
+%
+%     'BOOTSTAT = bootmerge (FILES)' loads the MAT-files saved by calls to
+%     'bootstrp (..., 'seed', SEED, 'shard', [ID, NSHARDS], 'file', FILENAME)'
+%     and concatenates their bootstrap statistics in the order of the shard
+%     IDs. FILES is a cell array of file names, or a single file name if the
+%     bootstrap was not split. The files must contain every shard of the same
+%     bootstrap (i.e. with the same NBOOT, SEED and original estimates) exactly
+%     once. The merged BOOTSTAT is identical to the BOOTSTAT returned by a
+%     single call to bootstrp with the same SEED.
+%
+%     '[BOOTSTAT, BOOTSAM] = bootmerge (FILES)' also returns the merged indices
+%     used for bootstrap resampling (see help for the 'bootstrp' function).
+%
+%     '[BOOTSTAT, BOOTSAM, STATS] = bootmerge (FILES)' also calculates and
+%     returns the following basic statistics relating to each column of the
+%     merged BOOTSTAT:
+%        - original: the original estimate(s) calculated by BOOTFUN and the DATA
+%        - mean: the mean of the bootstrap distribution(s)
+%        - bias: bootstrap estimate of the bias of the sampling distribution(s)
+%        - bias_corrected: original estimate(s) after subtracting the bias
+%        - var: bootstrap variance of the original estimate(s)
+%        - std_error: bootstrap estimate(s) of the standard error(s)
+%     Confidence intervals can be computed from the merged BOOTSTAT using the
+%     'bootint' function.
+%
+%  bootmerge (version 2026.10.17)
+%  Author: Andrew Charles Penn
+%  https://www.researchgate.net/profile/Andrew_Penn/
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function [bootstat, bootsam, stats] = bootmerge (files)
+
+  % Evaluate the number of function arguments
+  if (nargin < 1)
+    error ('bootmerge: FILES must be provided')
+  end
+  if (nargout > 3)
+    error ('bootmerge: Maximum of 3 output arguments can be requested')
+  end
+  if (ischar (files))
+    files = {files};
+  end
+  if (~ iscellstr (files))
+    error ('bootmerge: FILES must be a file name or a cell array of file names')
+  end
+
+  % Load the shards
+  nfiles = numel (files);
+  S = cell (1, nfiles);
+  for i = 1:nfiles
+    S{i} = load (files{i});
+    if (~ all (isfield (S{i}, {'bootstat', 'bootsam', 'original', 'nboot', ...
+                                'seed', 'shard', 'cols'})))
+      error ('bootmerge: %s was not saved by bootstrp', files{i})
+    end
+  end
+
+  % Check that the shards belong to the same bootstrap and that each of them
+  % is present exactly once
+  nboot = S{1}.nboot;
+  nshards = S{1}.shard(2);
+  for i = 2:nfiles
+    if ((S{i}.nboot ~= nboot) || (S{i}.shard(2) ~= nshards) || ...
+        (~ isequal (S{i}.seed, S{1}.seed)) || ...
+        (~ isequal (S{i}.original, S{1}.original)))
+      error (cat (2, 'bootmerge: The FILES are not from shards of the same', ...
+                     ' bootstrap'))
+    end
+  end
+  id = cellfun (@(S) S.shard(1), S);
+  if (~ isequal (sort (id), 1 : nshards))
+    error (cat (2, 'bootmerge: The FILES must contain each of the ', ...
+                   sprintf ('%u shards exactly once', nshards)))
+  end
+
+  % Concatenate the shards in order
+  [jnk, ord] = sort (id);
+  S = S(ord);
+  bootstat = cell2mat (cellfun (@(S) S.bootstat, S.', 'UniformOutput', false));
+  if (nargout > 1)
+    if (iscell (S{1}.bootsam))
+      nvar = numel (S{1}.bootsam);
+      bootsam = arrayfun (@(v) double (cell2mat (cellfun (@(S) ...
+                          S.bootsam{v}, S, 'UniformOutput', false))), ...
+                          1 : nvar, 'UniformOutput', false);
+    else
+      bootsam = double (cell2mat (cellfun (@(S) S.bootsam, S, ...
+                                           'UniformOutput', false)));
+    end
+  end
+
+  % Compute and return statistics that characterize the bootstrap distribution
+  if (nargout > 2)
+    stats = struct;
+    stats.original = reshape (S{1}.original, 1, []);
+    if (~ isempty (stats.original))
+      try
+        stats.mean = mean (bootstat);
+        stats.bias = bsxfun (@minus, stats.mean, stats.original);
+        stats.bias_corrected = bsxfun (@minus, stats.original, stats.bias);
+        stats.var = var (bootstat, 0);
+        stats.std_error = sqrt (stats.var);
+      catch
+        % Do not create fields for statistics that we cannot calculate
+      end
+    end
+  end
+
+end
+
+%!test
+%! % Test that merging the shards of a bootstrap reproduces a single run
+%! X = [212 435 339 251 404 510 377 335 410 335 ...
+%!      415 356 339 188 256 296 249 303 266 300]';
+%! Y = [247 461 526 302 636 593 393 409 488 381 ...
+%!      474 329 555 282 423 323 256 431 437 240]';
+%! [bootstat, bootsam, stats] = bootstrp (50, @mean, X, 'seed', 1);
+%! files = arrayfun (@(i) cat (2, tempname (), '.mat'), 1:3, ...
+%!                   'UniformOutput', false);
+%! for i = 3:-1:1
+%!   bootstrp (50, @mean, X, 'seed', 1, 'shard', [i, 3], 'file', files{i});
+%! end
+%! [mbootstat, mbootsam, mstats] = bootmerge (files);
+%! assert (mbootstat, bootstat);
+%! assert (mbootsam, bootsam);
+%! assert (mstats.std_error, stats.std_error, 1e-12);
+%! [bootstat, bootsam] = bootstrp (50, @(x, y) mean (x) - mean (y), X, Y, ...
+%!                                 'match', false, 'seed', 1);
+%! for i = 1:3
+%!   bootstrp (50, @(x, y) mean (x) - mean (y), X, Y, 'match', false, ...
+%!             'seed', 1, 'shard', [i, 3], 'file', files{i});
+%! end
+%! [mbootstat, mbootsam] = bootmerge (files(end:-1:1));
+%! assert (mbootstat, bootstat);
+%! assert (mbootsam, bootsam);
+%! cellfun (@delete, files);
@@ -0,0 +1,121 @@
+% Reads a matrix of bootstrap statistics or resampling indices, in whole or by
+% column, from a binary file written by the 'bootwrite' or 'boot' functions.
+%
+% -- Function File: X = bootread (FILENAME)
+% -- Function File: X = bootread (FILENAME, COLS)
+% -- Function File: [X, INFO] = bootread (...)
+%
+%     'X = bootread (FILENAME)' reads the whole matrix stored in FILENAME by
+%     the 'bootwrite' function, or by 'boot (..., FILENAME)'. X is returned as
+%     a double precision matrix, regardless of the data type used to store it.
+%
+%     'X = bootread (FILENAME, COLS)' reads only the columns (i.e. resamples)
+%     with the indices in the vector COLS. Each run of consecutive columns is
+%     read directly from its position in the file, so a subset of the
+%     resamples can be used without reading the rest of the file into memory.
+%
+%     '[X, INFO] = bootread (...)' also returns a structure with the fields
+%     rows, cols and class, which describe the matrix stored in the file. To
+%     get INFO without reading any columns, set COLS to empty (i.e. []).
+%
+%  bootread (version 2026.10.17)
+%  Author: Andrew Charles Penn
+%  https://www.researchgate.net/profile/Andrew_Penn/
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function [X, info] = bootread (filename, cols)
+
+  % Check input arguments
+  if (nargin < 1)
+    error ('bootread: FILENAME must be provided')
+  end
+  if (~ ischar (filename))
+    error ('bootread: FILENAME must be a character array')
+  end
+
+  % Read the file header
+  [fid, msg] = fopen (filename, 'r', 'ieee-le');
+  if (fid < 0)
+    error ('bootread: Could not open %s (%s)', filename, msg)
+  end
+  magic = fread (fid, [1, 8], 'char=>char');
+  if (~ strcmp (magic, 'BOOTMAT1'))
+    fclose (fid);
+    error ('bootread: %s is not a bootwrite file', filename)
+  end
+  type = fread (fid, 1, 'uint32');
+  fread (fid, 1, 'uint32');
+  rows = fread (fid, 1, 'uint64');
+  ncols = fread (fid, 1, 'uint64');
+  types = {'double', 'uint8', 'uint16', 'uint32'};
+  bytes = [8, 1, 2, 4];
+  if ((type < 0) || (type > 3))
+    fclose (fid);
+    error ('bootread: %s has an unknown data type', filename)
+  end
+  info = struct ('rows', rows, 'cols', ncols, 'class', types{type + 1});
+  precision = cat (2, types{type + 1}, '=>double');
+  width = bytes(type + 1);
+
+  % Evaluate the columns to read
+  if (nargin < 2)
+    cols = 1 : ncols;
+  end
+  cols = cols(:)';
+  if (any (cols ~= fix (cols)) || any (cols < 1) || any (cols > ncols))
+    fclose (fid);
+    error ('bootread: COLS must be integers between 1 and %u', ncols)
+  end
+
+  % Read each run of consecutive columns in one operation
+  [u, jnk, loc] = unique (cols);
+  Y = zeros (rows, numel (u));
+  if (~ isempty (u))
+    runs = [0, find (diff (u) ~= 1), numel (u)];
+    for i = 1 : numel (runs) - 1
+      idx = runs(i) + 1 : runs(i + 1);
+      fseek (fid, 32 + (u(idx(1)) - 1) * rows * width, 'bof');
+      Y(:, idx) = fread (fid, [rows, numel(idx)], precision);
+    end
+  end
+  fclose (fid);
+  X = Y(:, loc);
+
+end
+
+%!test
+%! % Test reading selected columns
+%! file = tempname ();
+%! X = reshape (1:40, 4, 10) + 0.5;
+%! bootwrite (file, X);
+%! assert (bootread (file), X);
+%! assert (bootread (file, [2, 3, 4, 9, 3]), X(:, [2, 3, 4, 9, 3]));
+%! [Y, info] = bootread (file, []);
+%! assert (size (Y), [4, 0]);
+%! assert ([info.rows, info.cols], [4, 10]);
+%! delete (file);
+
+%!test
+%! % Test that boot writes the same BOOTSAM to a file as it returns
+%! file = tempname ();
+%! bootsam = boot (5, 20, true, 1);
+%! boot (5, 20, true, 1, [], file);
+%! assert (bootread (file), bootsam);
+%! bootsam = boot ([1.5, 2.5, 4], 20, false, 1);
+%! boot ([1.5, 2.5, 4], 20, false, 1, [], file);
+%! assert (bootread (file), bootsam);
+%! delete (file);
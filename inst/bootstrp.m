@@ -9,6 +9,8 @@
 % -- Function File: BOOTSTAT = bootstrp (..., 'Weights', WEIGHTS)
 % -- Function File: BOOTSTAT = bootstrp (..., 'loo', LOO)
 % -- Function File: BOOTSTAT = bootstrp (..., 'seed', SEED)
+% -- Function File: BOOTSTAT = bootstrp (..., 'seed', SEED, 'shard', SHARD)
+% -- Function File: BOOTSTAT = bootstrp (..., 'file', FILENAME)
 % -- Function File: [BOOTSTAT, BOOTSAM] = bootstrp (...)
 % -- Function File: [BOOTSTAT, BOOTSAM, STATS] = bootstrp (...)
 %
@@ -76,6 +78,20 @@
 %     random number generator using an integer SEED value so that bootci results
 %     are reproducible.
 %
+%     'BOOTSTAT = bootstrp (..., 'seed', SEED, 'shard', SHARD)' splits the
+%     NBOOT resamples into contiguous shards so that the bootstrap can be run
+%     by several independent processes. SHARD is a pair of positive integers,
+%     [ID, NSHARDS], and only the resamples of shard number ID out of NSHARDS
+%     are evaluated and returned. All of the shards must be run with the same
+%     SEED (which is required), NBOOT and data, so that the concatenation of
+%     their BOOTSTAT and BOOTSAM outputs is identical to a single run of
+%     bootstrp with the same SEED. See also the 'bootmerge' function.
+%
+%     'BOOTSTAT = bootstrp (..., 'file', FILENAME)' also saves BOOTSTAT and
+%     BOOTSAM, together with the original estimate(s), NBOOT, SEED and SHARD,
+%     to the MAT-file FILENAME. The files from the shards of a bootstrap can be
+%     combined using the 'bootmerge' function.
+%
 %     '[BOOTSTAT, BOOTSAM] = bootstrp (...)' also returns indices used for
 %     bootstrap resampling. If MATCH is true or only one data argument is
 %     provided, BOOTSAM is a matrix. If multiple data arguments are provided
@@ -156,6 +172,8 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
   loo = false;
   match = true;
   seed = [];
+  shard = [];
+  file = '';
 
   % Assign input arguments to function variables
   nboot = argin1;
@@ -177,6 +195,10 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
           seed = value;
         case 'loo'
           loo = value;
+        case 'shard'
+          shard = value;
+        case 'file'
+          file = value;
         otherwise
           error ('bootstrp: Unrecognised input argument to bootstrp')
       end
@@ -223,6 +245,27 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
     error ('bootstrp: NBOOT must be a scalar value')
   end
 
+  % shard input argument
+  if (isempty (shard))
+    shard = [1, 1];
+  else
+    if ((~ isnumeric (shard)) || (numel (shard) ~= 2) || ...
+        any (shard ~= abs (fix (shard))) || (shard(1) < 1) || ...
+        (shard(1) > shard(2)))
+      error (cat (2, 'bootstrp: SHARD must be a pair of positive integers', ...
+                     ' [ID, NSHARDS], where ID <= NSHARDS'))
+    end
+    if (isempty (seed))
+      error ('bootstrp: SEED must be provided to run a SHARD of the bootstrap')
+    end
+  end
+  % Columns of the resamples in this shard
+  cols = fix ((shard(1) - 1) * nboot / shard(2)) + 1 : ...
+         fix (shard(1) * nboot / shard(2));
+  if (~ ischar (file))
+    error ('bootstrp: FILE must be a file name')
+  end
+
   % If applicable, check we have parallel computing capabilities
   if (ncpus > 1)
     if (ISOCTAVE)
@@ -360,10 +403,9 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
   end
 
   % Evaluate weights argument and convert each set of sampling probabilities to
-  % a weighting vector that sums to N * NBOOT
+  % a weighting vector of integer counts that sums to N * NBOOT
   if (isempty (w))
-    w = cellfun (@(n) ones (n, 1) / n, n, 'UniformOutput', false);
-    s = num2cell (ones (1, nvar), 1);
+    w = cellfun (@(n) ones (n, 1) * nboot, n, 'UniformOutput', false);
   else
     if (match)
       if (isnumeric (w))
@@ -390,17 +432,11 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
     if (any (arrayfun (@(v) any (isnan(w{v})), 1 : nvar)))
       error ('bootstrp: Weights cannot contain NaN values')
     end
-    s = arrayfun (@(v) fzero (@(s) sum (round (s * w{v} / mean (w{v}) * nboot) ...
-                                - nboot), 1), 1 : nvar, 'UniformOutput', false);
-  end
-  w = arrayfun (@(v) round (s{v} * w{v} / mean (w{v}) * nboot), ...
-                            1 : nvar, 'UniformOutput', false);
-  if (~ isempty (w))
-    % Fail safe to guarantee that the sum of the weights equals n * nboot
-    for v = 1:nvar
-      [wmax, imax] = max (w{v});
-      w{v}(imax) = wmax + nboot * n{v} - sum (w{v});
+    if (any (arrayfun (@(v) ~ any (w{v}), 1 : nvar)))
+      error ('bootstrp: Weights cannot all be zero')
     end
+    w = arrayfun (@(v) apportion (w{v}, n{v} * nboot), 1 : nvar, ...
+                  'UniformOutput', false);
   end
 
   % Perform balanced bootstrap resampling
@@ -411,6 +447,15 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
     bootsam = cellfun (@(n, w) boot (n, nboot, loo, seed, w), ... 
                          n', w', 'UniformOutput', false);
   end
+  if (shard(2) > 1)
+    % Keep only the resamples of this shard. Every shard draws the same
+    % balanced resamples from the SEED, so the shards together are identical
+    % to a single run
+    bootsam = cellfun (@(bootsam) bootsam(:, cols), bootsam, ...
+                       'UniformOutput', false);
+  end
+  nbootall = nboot;
+  nboot = numel (cols);
   if (isempty (bootfun))
     bootstat = zeros (nboot, 0);
   else
@@ -419,28 +464,32 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
       if (ISOCTAVE)
         % OCTAVE
         bootstat = parcellfun (ncpus, ...
-                           @(i) parsubfun.booteval (x, i, bootfun, n, nvar), ...
-                                           num2cell (cell2mat (bootsam), 1), ...
+                         @(b) parsubfun.booteval (x, bootsam, b, bootfun, nvar), ...
+                                           num2cell (1 : nboot), ...
                                            'UniformOutput', false);
       else
         % MATLAB
-        parbootsam = num2cell (cell2mat (bootsam), 1);
         bootstat = cell (1, nboot);
         parfor b = 1:nboot 
-          bootstat{b} = booteval (x, parbootsam{b}, bootfun, n, nvar);
+          bootstat{b} = booteval (x, bootsam, b, bootfun, nvar);
         end
       end
     else
       % Serial processing
+      bootstat = cell (1, nboot);
       if (vectorized)
-        % Fast: Vectorized evaluation of bootfun on the resamples
-        XR = arrayfun (@(v) x{v}(bootsam{v}), 1 : nvar, 'UniformOutput', false);
-        bootstat = num2cell (bootfun (XR{:}), 1);
+        % Fast: Vectorized evaluation of bootfun on blocks of resamples
+        blksz = max (1, fix (1e+07 / sum ([n{:}])));
+        for b = 1 : blksz : nboot
+          idx = b : min (b + blksz - 1, nboot);
+          XR = gather (x, bootsam, idx, nvar);
+          bootstat(idx) = num2cell (bootfun (XR{:}), 1);
+        end
       else
         % Slow: Looped evaluation of bootfun on the resamples
-        bootstat = cellfun (@(i) booteval (x, i, bootfun, n, nvar), ...
-                                 num2cell (cell2mat (bootsam), 1), ...
-                                 'UniformOutput', false);
+        for b = 1:nboot
+          bootstat{b} = booteval (x, bootsam, b, bootfun, nvar);
+        end
       end
     end
     bootstat = [bootstat{:}]';
@@ -452,6 +501,22 @@ function [bootstat, bootsam, stats] = bootstrp (argin1, argin2, varargin)
     bootsam = bootsam';
   end
 
+  % Save the bootstrap statistics and resamples, along with the information
+  % needed to merge them with the other shards, to a MAT-file
+  if (~ isempty (file))
+    S = struct ('bootstat', bootstat, 'bootsam', [], 'original', [], ...
+                'nboot', nbootall, 'seed', seed, 'shard', shard, 'cols', cols);
+    if (iscell (bootsam))
+      S.bootsam = cellfun (@int32, bootsam, 'UniformOutput', false);
+    else
+      S.bootsam = int32 (bootsam);
+    end
+    if (~ isempty (bootfun))
+      S.original = t0;
+    end
+    save (file, '-struct', 'S', '-v7');
+  end
+
   % Compute and return statistics that characterize the bootstrap distribution
   if (nargout > 2)
     stats = struct;
@@ -476,21 +541,50 @@ end
 
 %--------------------------------------------------------------------------
 
-function bootstat = booteval (x, bootsam, bootfun, n, nvar)
+function bootstat = booteval (x, bootsam, b, bootfun, nvar)
+
+    % Helper subfunction to resample x using column b of bootsam and evaluate
+    % bootfun
+    xr = gather (x, bootsam, b, nvar);
+    bootstat = reshape (bootfun (xr{:}), [], 1);
 
-    % Helper subfunction to resample x using bootsam and evaluate bootfun
-    if (nvar > 1)
-      i = mat2cell (bootsam, cell2mat (n));
-      xr = arrayfun (@(v) x{v}(i{v}, :), 1 : nvar, 'UniformOutput', false);
-      bootstat = reshape (bootfun (xr{:}), [], 1);
+end
+
+%--------------------------------------------------------------------------
+
+function XR = gather (x, bootsam, idx, nvar)
+
+    % Helper subfunction to gather the resampled datasets for the bootstrap
+    % replicates in idx directly from the matrix of indices for each dataset.
+    % When idx is a block of replicates, the data must be column vectors and
+    % each resampled dataset is returned as an n x numel (idx) matrix
+    XR = cell (1, nvar);
+    if (isscalar (idx))
+      for v = 1:nvar
+        XR{v} = x{v}(bootsam{v}(:, idx), :);
+      end
     else
-      % Faster when nvar is only one
-      xr = x{1}(bootsam, :);
-      bootstat = reshape (bootfun (xr), [], 1);
+      for v = 1:nvar
+        XR{v} = x{v}(bootsam{v}(:, idx));
+      end
     end
 
 end
 
+%--------------------------------------------------------------------------
+
+function c = apportion (w, N)
+
+    % Helper subfunction to convert a vector of weights to integer counts that
+    % sum exactly to N using the largest remainder method
+    q = w(:) / sum (w) * N;
+    c = floor (q);
+    r = min (max (round (N - sum (c)), 0), numel (c));
+    [jnk, i] = sort (q - c, 'descend');
+    c(i(1:r)) = c(i(1:r)) + 1;
+
+end
+
 %!demo
 %!
 %! % Input univariate dataset
@@ -657,3 +751,11 @@ end
 %! bootstrp (50, @mean, X, 'Weights', rand (20, 1));
 %! bootstrp (50, @mean, X, 'seed', 1, 'loo', false, 'Weights', rand (20, 1));
 
+%!test
+%! % Check the conversion of weights to integer counts
+%! X = (1:4)';
+%! [jnk, bootsam] = bootstrp (10, [], X, 'Weights', [1; 1; 1; 2]);
+%! assert (accumarray (bootsam(:), 1), [8; 8; 8; 16]);
+%! [jnk, bootsam] = bootstrp (10, [], X, 'Weights', [1; 2; 3; 0]);
+%! assert (accumarray (bootsam(:), 1), [7; 13; 20]);
+
@@ -59,6 +59,14 @@
 %     where NBOOT must be a positive integer. If empty, the default value of
 %     NBOOT is 1999.
 %
+%     'bootwild (y, X, ..., [NBOOT, TOL])' generates the bootstrap resamples
+%     in a first batch of 999, and then in batches of 499, and stops once the
+%     Monte Carlo standard errors of the confidence interval bounds (in units
+%     of the standard error) and of the p-values all fall below the tolerance,
+%     TOL, or once NBOOT resamples have been generated. Like a fixed NBOOT,
+%     at least 999 resamples are therefore generated. TOL must be a positive
+%     scalar less than 1.
+%
 %     'bootwild (y, X, ..., NBOOT, ALPHA)' is numeric and sets the lower and
 %     upper bounds of the confidence interval(s). The value(s) of ALPHA must
 %     be between 0 and 1. ALPHA can either be:
@@ -74,7 +82,10 @@
 %
 %     'bootwild (y, X, ..., NBOOT, ALPHA, SEED)' initialises the Mersenne
 %     Twister random number generator using an integer SEED value so that
-%     'bootwild' results are reproducible.
+%     'bootwild' results are reproducible. Note that the random multipliers
+%     are generated in blocks of fix (1e+07 / n) resamples, so for large
+%     problems (n * NBOOT > 1e+07), the results for a given SEED differ from
+%     those of versions that generated all of the multipliers at once.
 %
 %     'bootwild (y, X, ..., NBOOT, ALPHA, SEED, L)' multiplies the regression
 %     coefficients by the hypothesis matrix L. If L is not provided or is empty,
@@ -132,13 +143,17 @@
 
 
 function [stats, bootstat, bootsse, bootfit] = bootwild (y, X, ...
-                                          dep, nboot, alpha, seed, L, ISOCTAVE)
+                                 dep, nboot, alpha, seed, L, ISOCTAVE, FACTORS)
+
+  % Input argument names in all-caps are for internal use only
+  % ISOCTAVE and FACTORS are undocumented input arguments used by bootlm.
+  % FACTORS is the factorization of the design matrix X (see factorize).
 
   % Check the number of function arguments
   if (nargin < 1)
     error ('bootwild: y must be provided')
   end
-  if (nargin > 8)
+  if (nargin > 9)
     error ('bootwild: Too many input arguments')
   end
   if (nargout > 4)
@@ -220,13 +235,12 @@ function [stats, bootstat, bootsse, bootfit] = bootwild (y, X, ...
       G = numel (C); % Number of clusters
       method = 'cluster ';
     end
-    UC = unique (IC);
-    clusters = cell2mat (cellfun (@(i) IC == UC(i), ...
-                                  num2cell (1:G), 'UniformOutput', false));
+    % Sparse matrix that sums the rows of a matrix within each cluster
+    M = sparse (IC, (1:n)', 1, G, n);
   else
     G = n;
     IC = [];
-    clusters = [];
+    M = [];
     method = '';
   end
 
@@ -238,14 +252,22 @@ function [stats, bootstat, bootsse, bootfit] = bootwild (y, X, ...
   c = (G / (G - 1)) * ((n - 1) / (n - k));
 
   % Evaluate number of bootstrap resamples
+  tol = 0;
   if ( (nargin < 4) || (isempty (nboot)) )
     nboot = 1999;
   else
     if (~ isa (nboot, 'numeric'))
       error ('bootwild: NBOOT must be numeric')
     end
+    if (numel (nboot) > 2)
+      error ('bootwild: NBOOT must be scalar or a pair [NBOOT, TOL]')
+    end
     if (numel (nboot) > 1)
-      error ('bootwild: NBOOT must be scalar')
+      tol = nboot(2);
+      nboot = nboot(1);
+      if ((tol <= 0) || (tol >= 1))
+        error ('bootwild: TOL must be between 0 and 1')
+      end
     end
     if (nboot ~= abs (fix (nboot)))
       error ('bootwild: NBOOT must be a positive integer')
@@ -254,9 +276,6 @@ function [stats, bootstat, bootsse, bootfit] = bootwild (y, X, ...
       error ('bootwild: NBOOT must be >= 999')
     end
   end
-  % Compute resolution limit of the p-values as determined by resampling
-  % with nboot resamples
-  res_lim = 1 / (nboot + 1);
 
   % Evaluate alpha
   if ( (nargin < 5) || isempty (alpha) )
@@ -289,41 +308,101 @@ function [stats, bootstat, bootsse, bootfit] = bootwild (y, X, ...
     rand ('seed', seed);
   end
 
-  % Compute unscaled covariance matrix by QR decomposition (instead of using
-  % the less accurate method of getting to the solution directly with normal
-  % equations)
-  [Q, R] = qr (X, 0);        % Economy-sized QR decomposition
-  ucov = pinv (R' * R);      % Instead of pinv (X' * X)
-
+  % Compute the pseudoinverse of the design matrix and the unscaled covariance
+  % matrix by QR decomposition (instead of using the less accurate method of
+  % getting to the solution directly with normal equations). The factorization
+  % is computed just once, unless it has been provided already.
+  if ( (nargin < 9) || isempty (FACTORS) || any (excl) )
+    FACTORS = factorize (X);
+  end
+  pinvX = FACTORS.pinv;      % Instead of pinv (X)
+  ucov = FACTORS.ucov;       % Instead of pinv (X' * X)
 
-  % Create least squares anonymous function for bootstrap
-  bootfun = @(y) lmfit (X, y, ucov, clusters, c, L, ISOCTAVE);
+  % The contributions of each observation to the robust standard errors of
+  % the parameters are weighted by the rows of X * ucov * L (see lmfit)
+  Z = X * (ucov * L);
 
   % Calculate estimate(s)
-  S = bootfun (y);
+  S = lmfit (X, y, pinvX, Z, M, c, L);
   original = S.b;
   std_err = S.se;
   sse = S.sse;
   t = original ./ std_err;
 
-  % Wild bootstrap resampling (Webb's 6-point distribution)
-  s = sign (rand (G, nboot) - 0.5) .* ...
-      sqrt (0.5 * (fix (rand (G, nboot) * 3) + 1));
-  if (~ isempty (IC))
-    s = s(IC, :);  % Enforce clustering/blocking
-  end
-  yf = X * pinv (X) * y;
+  % Wild bootstrap resampling (Webb's 6-point distribution). In adaptive mode
+  % (TOL > 0), the resamples are generated and evaluated in batches until the
+  % Monte Carlo error of the intervals and p-values is within tolerance. The
+  % first batch has the minimum number of resamples (999).
+  yf = X * (pinvX * y);
   r = y - yf;
-  rs = bsxfun (@times, r, s);
-  Y = bsxfun (@plus, yf, rs);
+  if (tol > 0)
+    batchsz = 499;
+  else
+    batchsz = nboot;
+  end
+  bootstat = zeros (p, 0);
+  bootse = zeros (p, 0);
+  bootsse = zeros (1, 0);
+  if (nargout > 3)
+    bootfit = zeros (n, 0);
+  end
+  B = 0;
+  while (B < nboot)
+    if (B == 0)
+      nb = min (max (batchsz, 999), nboot);
+    else
+      nb = min (batchsz, nboot - B);
+    end
+
+    % Compute bootstap statistics. The multipliers are generated, and the
+    % linear model is fit, for blocks of bootstrap resamples at a time to limit
+    % the memory used by the multipliers and the resampled data.
+    bootstat(:, B + (1:nb)) = 0;
+    bootse(:, B + (1:nb)) = 0;
+    bootsse(B + (1:nb)) = 0;
+    blksz = max (1, fix (1e+07 / n));
+    for b = 1:blksz:nb
+      idx = b:min (b + blksz - 1, nb);
+      s = sign (rand (G, numel (idx)) - 0.5) .* ...
+          sqrt (0.5 * (fix (rand (G, numel (idx)) * 3) + 1));
+      if (isempty (IC))
+        Y = bsxfun (@plus, yf, bsxfun (@times, r, s));
+      else
+        % Enforce clustering/blocking
+        Y = bsxfun (@plus, yf, bsxfun (@times, r, s(IC, :)));
+      end
+      S = lmfit (X, Y, pinvX, Z, M, c, L);
+      bootstat(:, B + idx) = S.b;
+      bootse(:, B + idx) = S.se;
+      bootsse(B + idx) = S.sse;
+      if (nargout > 3)
+        bootfit(:, B + idx) = S.fit;
+      end
+    end
+    B = B + nb;
+
+    % Stopping rule for adaptive mode
+    if ((tol > 0) && (B < nboot))
+      T = bsxfun (@minus, bootstat, original) ./ bootse;
+      q = mean (bsxfun (@ge, abs (T), abs (t)), 2);
+      mcse = sqrt (q .* (1 - q) / B);
+      if (any (~ isnan (alpha)))
+        if (nalpha > 1)
+          mcse = cat (2, mcse, quantse (T, alpha(1)), quantse (T, alpha(2)));
+        else
+          mcse = cat (2, mcse, quantse (abs (T), 1 - alpha));
+        end
+      end
+      if (all (mcse(:) <= tol))
+        break
+      end
+    end
+  end
+  nboot = B;
 
-  % Compute bootstap statistics
-  bootout = cell2mat (cellfun (bootfun, num2cell (Y, 1), ...
-                              'UniformOutput', false));
-  bootstat = [bootout.b];
-  bootse = [bootout.se];
-  bootsse = [bootout.sse];
-  bootfit = [bootout.fit];
+  % Compute resolution limit of the p-values as determined by resampling
+  % with nboot resamples
+  res_lim = 1 / (nboot + 1);
 
   % Studentize the bootstrap statistics and compute two-tailed confidence
   % intervals and p-values following both guidelines described in Hall and
@@ -383,13 +462,14 @@ end
 
 % FUNCTION TO FIT THE LINEAR MODEL
 
-function S = lmfit (X, y, ucov, clusters, c, L, ISOCTAVE)
+function S = lmfit (X, Y, pinvX, Z, M, c, L)
 
-  % Get model coefficients by solving the linear equation by matrix arithmetic
+  % Get model coefficients by solving the linear equation by matrix arithmetic.
+  % Each column of Y is a separate outcome to fit the model to.
 
   % Solve linear equation to minimize least squares and compute the
   % regression coefficients (b) 
-  b = pinv (X) * y;                 % Instead of inv (X' * X) * (X' * y);
+  b = pinvX * Y;                    % Instead of inv (X' * X) * (X' * y);
 
   % Calculate heteroscedasticity-consistent (HC) or cluster robust (CR) standard 
   % errors for the regression coefficients. When the number of observations
@@ -398,30 +478,57 @@ function S = lmfit (X, y, ucov, clusters, c, L, ISOCTAVE)
   %   Long and Ervin (2000) Am. Stat, 54(3), 217-224
   %   Cameron, Gelbach and Miller (2008) Rev Econ Stat. 90(3), 414-427
   %   MacKinnon & Webb (2020) QED Working Paper Number 1421
+  % The variance of parameter j, i.e. the diagonal of L' * vcov * L where
+  % vcov = c * ucov * meat * ucov, is computed without forming the meat matrix
+  % for each fit. With Z = X * ucov * L, it is c times the sum over clusters
+  % of the squared cluster sums of Z(:,j) .* u (i.e. the per-cluster scores).
   yf = X * b;
-  u = y - yf;
-  if ( (nargin < 3) || isempty (clusters) )
+  u = Y - yf;
+  if (isempty (M))
     % For Heteroscedasticity-Consistent (HC) standard errors
-    meat = X' * diag (u.^2) * X;
+    V = (Z.^2)' * u.^2;
   else
     % For Cluster Robust (CR) standard errors
-    Sigma = cellfun (@(g) X(g,:)' * u(g) * u(g)' * X(g,:), ...
-                  num2cell (clusters, 1), 'UniformOutput', false);
-    meat = sum (cat (3, Sigma{:}), 3);
+    V = zeros (size (Z, 2), size (Y, 2));
+    for j = 1:size (Z, 2)
+      V(j, :) = sum ((M * bsxfun (@times, Z(:, j), u)).^2, 1);
+    end
   end
-  % Calculate variance-covariacnce matrix including a finite sample correction
-  % factor to give HC1 or CR1 estimates
-  vcov = c * ucov * meat * ucov;
+  % Calculate standard errors including a finite sample correction factor to 
+  % give HC1 or CR1 estimates
   S = struct; 
-  if ( (nargin < 4) || isempty (L) )
-    S.b = b;
-    S.se = sqrt (max (diag (vcov), 0));
+  S.b = L' * b;
+  S.se = sqrt (c * V);
+  S.sse = sum (u.^2, 1);
+  S.fit = yf;
+
+end
+
+%--------------------------------------------------------------------------
+
+% FUNCTION TO FACTORIZE THE DESIGN MATRIX
+
+function F = factorize (X)
+
+  % Returns a structure containing the Moore-Penrose pseudoinverse of X (pinv)
+  % and the unscaled covariance matrix (ucov), i.e. pinv (X' * X). When X has
+  % full column rank, both are obtained from an economy-sized QR decomposition
+  % of X. Otherwise, they are computed from the singular value decomposition of
+  % X, using the same tolerance for rank determination as pinv.
+  [n, k] = size (X);
+  [Q, R] = qr (X, 0);
+  d = abs (diag (R));
+  F = struct ('pinv', [], 'ucov', []);
+  if ( (n >= k) && all (d > max (n, k) * max (d) * eps) )
+    F.pinv = R \ Q';
+    F.ucov = R \ (R' \ eye (k));
   else
-    S.b = L' * b;
-    S.se = sqrt (max (diag (L' * vcov * L), 0));
+    [U, S, V] = svd (X, 0);
+    s = diag (S);
+    i = s > max (n, k) * max (s) * eps;
+    F.pinv = V(:, i) * diag (1 ./ s(i)) * U(:, i)';
+    F.ucov = V(:, i) * diag (1 ./ s(i).^2) * V(:, i)';
   end
-  S.sse = sum (u.^2);
-  S.fit = yf;
 
 end
 
@@ -569,6 +676,9 @@ end
 %! stats = bootwild(heights-H0,[],2);
 %! stats = bootwild(heights-H0,[],[1;1;2;2;3;3;4;4;5;5]);
 %! stats = bootwild(heights-H0,[],[],1999);
+%! stats = bootwild(heights-H0,[],[],[1999,0.05]);
+%! [stats,bootstat] = bootwild(heights-H0,[],[],[19999,0.5]);
+%! assert (size (bootstat, 2), 999);
 %! stats = bootwild(heights-H0,[],[],[],0.05);
 %! stats = bootwild(heights-H0,[],[],[],[0.025,0.975]);
 %! stats = bootwild(heights-H0,[],[],[],[],1);
@@ -0,0 +1,199 @@
+% Writes a matrix of bootstrap statistics or resampling indices to a binary file
+% that can be read back, in whole or by column, using the 'bootread' function.
+%
+% -- Function File: bootwrite (FILENAME, X)
+% -- Function File: bootwrite (FILENAME, X, CLASS)
+% -- Function File: bootwrite (FILENAME, X, CLASS, APPEND)
+%
+%     'bootwrite (FILENAME, X)' writes the numeric matrix X, such as BOOTSTAT
+%     or BOOTSAM returned by the functions of the statistics-resampling package,
+%     to the file FILENAME. The columns of X (i.e. the bootstrap resamples) are
+%     stored contiguously in column-major order after a short header, so that
+%     any range of columns can later be read without loading the whole file.
+%     By default, the values are stored as doubles.
+%
+%     'bootwrite (FILENAME, X, CLASS)' sets the data type used to store the
+%     values of X. CLASS can be 'double' (default), 'uint8', 'uint16', 'uint32'
+%     or 'index'. The latter stores X (e.g. a matrix of resampling indices) as
+%     the smallest unsigned integer type that can hold all of its values, which
+%     compresses the indices of samples with fewer than 256 or 65536 rows 8-fold
+%     or 4-fold respectively.
+%
+%     'bootwrite (FILENAME, X, CLASS, APPEND)' appends the columns of X to an
+%     existing file if APPEND is true, so that large matrices can be written in
+%     chunks of columns as they are computed. The number of rows of X must
+%     match the file, and the values of X must fit the data type of the file.
+%     CLASS is ignored when appending to an existing file. The default value of
+%     APPEND is false.
+%
+%     The 'boot' function can also write BOOTSAM directly to a file in this
+%     format, one column at a time, without holding it in memory:
+%       boot (N, NBOOT, LOO, SEED, WEIGHTS, FILENAME)
+%
+%     File format: The 8 character string 'BOOTMAT1', the data type code
+%     (uint32: 0 = double, 1 = uint8, 2 = uint16, 3 = uint32), a reserved
+%     field (uint32), and the number of rows and columns (uint64), followed by
+%     the values in column-major order. All fields are little-endian.
+%
+%  bootwrite (version 2026.10.17)
+%  Author: Andrew Charles Penn
+%  https://www.researchgate.net/profile/Andrew_Penn/
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function bootwrite (filename, X, classname, append)
+
+  % Check input arguments
+  if (nargin < 2)
+    error ('bootwrite: FILENAME and X must be provided')
+  end
+  if (~ ischar (filename))
+    error ('bootwrite: FILENAME must be a character array')
+  end
+  if ((~ isnumeric (X) && ~ islogical (X)) || (ndims (X) > 2) || ...
+      (~ isreal (X)))
+    error ('bootwrite: X must be a real numeric matrix')
+  end
+  if ((nargin < 3) || isempty (classname))
+    classname = 'double';
+  end
+  if ((nargin < 4) || isempty (append))
+    append = false;
+  end
+  types = {'double', 'uint8', 'uint16', 'uint32'};
+  [rows, cols] = size (X);
+
+  if (append && exist (filename, 'file'))
+
+    % Read the header of the existing file
+    [fid, msg] = fopen (filename, 'r+', 'ieee-le');
+    if (fid < 0)
+      error ('bootwrite: Could not open %s (%s)', filename, msg)
+    end
+    [type, nrows, ncols] = readheader (fid);
+    if (isempty (type))
+      fclose (fid);
+      error ('bootwrite: %s is not a bootwrite file', filename)
+    end
+    if (nrows ~= rows)
+      fclose (fid);
+      error ('bootwrite: X must have the same number of rows as the file')
+    end
+    precision = types{type + 1};
+    if (~ fits (X, precision))
+      fclose (fid);
+      error ('bootwrite: The values of X do not fit the %s data type of %s', ...
+             precision, filename)
+    end
+
+    % Write the columns of X to the end of the file and update the header
+    fseek (fid, 0, 'eof');
+    count = fwrite (fid, X, precision);
+    fseek (fid, 24, 'bof');
+    fwrite (fid, ncols + cols, 'uint64');
+    fclose (fid);
+
+  else
+
+    % Choose the data type
+    if (strcmpi (classname, 'index'))
+      m = max ([0; double(X(:))]);
+      if (m <= intmax ('uint8'))
+        classname = 'uint8';
+      elseif (m <= intmax ('uint16'))
+        classname = 'uint16';
+      else
+        classname = 'uint32';
+      end
+    end
+    type = find (strcmpi (classname, types)) - 1;
+    if (isempty (type))
+      error (cat (2, 'bootwrite: CLASS must be ''double'', ''uint8'',', ...
+                     ' ''uint16'', ''uint32'' or ''index'''))
+    end
+    precision = types{type + 1};
+    if (~ fits (X, precision))
+      error ('bootwrite: The values of X do not fit the %s data type', ...
+             precision)
+    end
+
+    % Write the header and the columns of X to a new file
+    [fid, msg] = fopen (filename, 'w', 'ieee-le');
+    if (fid < 0)
+      error ('bootwrite: Could not open %s (%s)', filename, msg)
+    end
+    fwrite (fid, 'BOOTMAT1', 'char');
+    fwrite (fid, [type, 0], 'uint32');
+    fwrite (fid, [rows, cols], 'uint64');
+    count = fwrite (fid, X, precision);
+    fclose (fid);
+
+  end
+  if (count ~= rows * cols)
+    error ('bootwrite: Could not write to %s', filename)
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function [type, rows, cols] = readheader (fid)
+
+  % Helper subfunction to read the header of a file written by bootwrite
+  magic = fread (fid, [1, 8], 'char=>char');
+  if (~ strcmp (magic, 'BOOTMAT1'))
+    type = [];
+    rows = [];
+    cols = [];
+    return
+  end
+  type = fread (fid, 1, 'uint32');
+  fread (fid, 1, 'uint32');
+  rows = fread (fid, 1, 'uint64');
+  cols = fread (fid, 1, 'uint64');
+
+end
+
+%--------------------------------------------------------------------------
+
+function retval = fits (X, precision)
+
+  % Helper subfunction to check that the values of X can be stored without
+  % loss in the data type given by precision
+  if (strcmp (precision, 'double') || isempty (X))
+    retval = true;
+  else
+    X = double (X(:));
+    retval = all (X == fix (X)) && (min (X) >= 0) && ...
+             (max (X) <= double (intmax (precision)));
+  end
+
+end
+
+%!test
+%! % Test writing and appending to a file
+%! file = tempname ();
+%! X = rand (5, 7);
+%! bootwrite (file, X(:, 1:3));
+%! bootwrite (file, X(:, 4:7), [], true);
+%! assert (bootread (file), X);
+%! bootsam = boot (300, 20, false, 1);
+%! bootwrite (file, bootsam(:, 1:10), 'index');
+%! bootwrite (file, bootsam(:, 11:20), [], true);
+%! [Y, info] = bootread (file);
+%! assert (Y, bootsam);
+%! assert (info.class, 'uint16');
+%! delete (file);
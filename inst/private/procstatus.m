@@ -0,0 +1,34 @@
+% Private helper function to read a field (in kB) from /proc/self/status, which
+% only exists on Linux. Returns NaN if the field cannot be read. Used by bootlm
+% (to profile its stages) and bootbench.
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function val = procstatus (field)
+
+  val = NaN;
+  fid = fopen ('/proc/self/status', 'r');
+  if (fid < 0)
+    return
+  end
+  str = fread (fid, Inf, 'char=>char')';
+  fclose (fid);
+  tok = regexp (str, cat (2, field, ':\s*(\d+)'), 'tokens', 'once');
+  if (~ isempty (tok))
+    val = str2double (tok{1});
+  end
+
+end
@@ -0,0 +1,32 @@
+% Private helper function to estimate the Monte Carlo standard error of the
+% q-quantile of the bootstrap statistics in each row of x, from the order
+% statistics that bracket it by one binomial standard error on either side.
+% q is a scalar or a column vector with a probability for each row of x. Used
+% by the stopping rules for adaptive NBOOT in bootknife, bootwild and bootbayes.
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function se = quantse (x, q)
+
+  [m, B] = size (x);
+  x = sort (x, 2);
+  q = bsxfun (@times, q, ones (m, 1));
+  d = sqrt (q .* (1 - q) / B);
+  lo = min (max (round (B * (q - d)), 1), B);
+  hi = min (max (round (B * (q + d)), 1), B);
+  se = (x(sub2ind ([m, B], (1:m)', hi)) - x(sub2ind ([m, B], (1:m)', lo))) / 2;
+
+end
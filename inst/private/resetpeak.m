@@ -0,0 +1,29 @@
+% Private helper function to reset the peak resident set size of the process
+% (on Linux) and return the current resident set size (in kB). Used by bootlm
+% (to profile its stages) and bootbench.
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function rss = resetpeak ()
+
+  fid = fopen ('/proc/self/clear_refs', 'w');
+  if (fid > 0)
+    fprintf (fid, '5');
+    fclose (fid);
+  end
+  rss = procstatus ('VmRSS');
+
+end
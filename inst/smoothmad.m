@@ -65,27 +65,30 @@ function PMAD = smoothmad (x, group, constant)
   end
 
   % Initialize variables
-  g = unique (group);
+  [g, jnk, gidx] = unique (group);
   l = numel (g);
   M = zeros (l, n);
   MAD = zeros (l, n);
-  nk = zeros (l, 1);
   PMAD = zeros (1, n);
 
+  % Sort the rows of the data by group once, so that the data for each group
+  % is a contiguous block of rows
+  [jnk, ord] = sort (gidx(:));
+  x = x(ord, :);
+  nk = accumarray (gidx(:), 1);
+  offset = cat (1, 0, cumsum (nk));
+
   % Perform calculations on each data group
   for k = 1:l
 
     % Collect the data for group k
-    I = (group == g(k));
-
-    % Calculate the size of the data group
-    nk(k) = sum(I);
+    xk = x(offset(k) + 1 : offset(k + 1), :);
 
     % Calculate the smoothed median of the data group 
-    M(k,:) = smoothmedian (x(I,:));
+    M(k,:) = smoothmedian (xk);
 
     % Calculate the smoothed median absolute deviation of the data group
-    MAD(k,:) = smoothmedian (abs (x(I, :) - M(k, :))) * constant;
+    MAD(k,:) = smoothmedian (abs (bsxfun (@minus, xk, M(k, :)))) * constant;
 
     % Begin pooling the smoothed median absolute deviations
     PMAD = PMAD + (nk(k) - 1) * MAD(k, :).^2;
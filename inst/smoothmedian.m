@@ -3,6 +3,9 @@
 % -- Function File: M = smoothmedian (X)
 % -- Function File: M = smoothmedian (X, DIM)
 % -- Function File: M = smoothmedian (X, DIM, TOL)
+% -- Function File: M = smoothmedian (X, DIM, TOL, NCPUS)
+% -- Function File: [M, INFO] = smoothmedian (...)
+% -- Function File: INFO = smoothmedian ('profile')
 %
 %     If X is a vector, find the univariate smoothed median (M) of X. If X is a
 %     matrix, compute the univariate smoothed median value for each column and
@@ -35,6 +38,38 @@
 %     The tolerance (TOL) is the maximum value of the step size that is
 %     acceptable to break from optimization. By default, TOL = range * 1e-04.
 %
+%     The MEX file version of this function processes the columns of X in
+%     parallel using a pool of threads that persists between calls. NCPUS sets
+%     the number of threads. By default, NCPUS is taken from the environment
+%     variable STATISTICS_RESAMPLING_NCPUS or, if that is not set, it is the
+%     number of cores on the machine. The results do not depend on NCPUS. The
+%     m-file version of this function ignores NCPUS.
+%
+%     '[M, INFO] = smoothmedian (...)' also instruments the call and returns a
+%     structure, INFO, with the following fields:
+%        o calls: the number of calls profiled (i.e. 1)
+%        o validation, allocation, copy, median, newton and total: the time (in
+%          seconds) spent on validation of the input arguments, allocation of
+%          memory, copying the data, finding the ordinary medians, iterating
+%          the Newton-Bisection algorithm, and in total. In the MEX file, the
+%          copy, median and newton timings are summed over the threads.
+%        o columns: the number of columns (or rows) of X
+%        o iterations, newton_steps and bisection_steps: the number of
+%          iterations, and of Newton and Bisection steps, summed over columns
+%        o pairs: the number of pairwise terms of the derivatives evaluated
+%        o failures: the number of columns that did not reach tolerance
+%        o threads and utilization: the number of threads, and the proportion
+%          of the time that they spent processing columns
+%        o bytes_allocated: the number of bytes allocated
+%
+%     'INFO = smoothmedian ('profile')' returns the sum of the counters and
+%     timings in INFO over all calls to smoothmedian since the totals were last
+%     returned, and then resets them. The totals are only recorded if the
+%     environment variable STATISTICS_RESAMPLING_PROFILE is set (to a value
+%     other than 0) before the calls, so that the time spent in smoothmedian by
+%     functions that call it (such as bootknife) can be attributed without
+%     external profilers (see also help for the 'boot' function).
+%
 %     The smoothing works by slightly reducing the breakdown point of the median.
 %     Bootstrap confidence intervals using the smoothed median have good
 %     coverage for the ordinary median of the population distribution and can be
@@ -50,7 +85,7 @@
 %  [1] Brown, Hall and Young (2001) The smoothed median and the
 %       bootstrap. Biometrika 88(2):519-534
 %
-%  smoothmedian (version 2023.05.02)
+%  smoothmedian (version 2026.10.17)
 %  Author: Andrew Charles Penn
 %  https://www.researchgate.net/profile/Andrew_Penn/
 %
@@ -69,14 +104,37 @@
 %  along with this program.  If not, see http://www.gnu.org/licenses/
 
 
-function M = smoothmedian (x, dim, Tol)
+function [M, info] = smoothmedian (x, dim, Tol, ncpus)
+
+  % Running totals of the instrumentation of calls to smoothmedian
+  persistent totals
+  if (isempty (totals))
+    totals = newprofile ();
+  end
+
+  % Return (and reset) the running totals of the instrumentation
+  if ((nargin == 1) && ischar (x))
+    if (~ strcmp (x, 'profile'))
+      error ('smoothmedian: The only valid string input argument is ''profile''')
+    end
+    M = totals;
+    totals = newprofile ();
+    return
+  end
+
+  % Start the clock (the call is instrumented if INFO is requested, or if the
+  % environment variable STATISTICS_RESAMPLING_PROFILE is set)
+  env = getenv ('STATISTICS_RESAMPLING_PROFILE');
+  accumulate = (~ isempty (env) && ~ strcmp (env, '0'));
+  info = newprofile ();
+  t0 = tic;
 
   % Evaluate input arguments
-  if (nargin < 1) || (nargin > 3)
+  if (nargin < 1) || (nargin > 4)
     error ('smoothmedian: Invalid number of input arguments')
   end
 
-  if (nargout > 1)
+  if (nargout > 2)
     error ('smoothmedian: Invalid number of output arguments')
   end
 
@@ -85,7 +143,7 @@ function M = smoothmedian (x, dim, Tol)
   end
 
   % Check data dimensions
-  if (nargin < 2)
+  if ((nargin < 2) || isempty (dim))
     if (size (x, 2) == 1)
       dim = 1;
     elseif (size (x, 1) == 1)
@@ -99,9 +157,11 @@ function M = smoothmedian (x, dim, Tol)
   end
 
   % If applicable, switch dimension
+  t = tic;
   if (dim > 1)
     x = x.';
   end
+  info.copy = toc (t);
 
   % Check input data type
   if (~ isa (x, 'double'))
@@ -113,8 +173,10 @@ function M = smoothmedian (x, dim, Tol)
   m = s(1);
   n = s(2);
   l = m * (m - 1) / 2;
+  info.validation = toc (t0) - info.copy;
   
   % Sort the data and calculate the median for each column of the data
+  t = tic;
   x = sort(x, 1);
   mid = 0.5 * m;
   M = x(fix (mid + 1), 1 : n); % Median when m is odd
@@ -135,9 +197,11 @@ function M = smoothmedian (x, dim, Tol)
   else 
     Tol = Tol * ones (1, n);
   end
+  info.median = toc (t);
 
   % Obtain m(m-1)/2 pairs from the Cartesian product of each column of
   % x with itself by enforcing the restriction i < j on xi and xj
+  t = tic;
   q = logical (triu (ones (m, m), 1));
   i = uint32 ((1:m)' * ones (1, m));
   xi = x(i(q), :);
@@ -152,10 +216,16 @@ function M = smoothmedian (x, dim, Tol)
   % Calculate commonly used operations and assign them to new variables
   z = (xi - xj).^2;
   y = xi + xj;
+  info.allocation = toc (t);
+  info.bytes_allocated = 8 * (m * n + 4 * l * n + 3 * l * n);
   
   % Minimize objective function (vectorized)
+  t = tic;
   MaxIter = 20;
   for Iter = 1:MaxIter
+
+    info.iterations = info.iterations + numel (p);
+    info.pairs = info.pairs + l * numel (p);
   
     % Compute derivatives
     temp = ones (l, 1) * p;
@@ -216,6 +286,8 @@ function M = smoothmedian (x, dim, Tol)
     % Prefer Newton step if it is within brackets
     I = (nwt > a) & (nwt < b);
     p(I) = nwt(I);
+    info.newton_steps = info.newton_steps + sum (I);
+    info.bisection_steps = info.bisection_steps + sum (~ I);
     
     % Otherwise, compute Bisection step (slow linear convergence but very safe)
     p(~I) = 0.5 * (a(~I) + b(~I));
@@ -228,6 +300,9 @@ function M = smoothmedian (x, dim, Tol)
     
   end
 
+  info.newton = toc (t);
+  info.failures = numel (idx);
+
   % Set the smoothmedian to NaN where columns/rows contain NaN
   M(any (isnan (x))) = NaN;
 
@@ -239,3 +314,34 @@ function M = smoothmedian (x, dim, Tol)
   if (dim > 1)
     M  = M.';
   end
+
+  % Return and/or accumulate the instrumentation
+  info.calls = 1;
+  info.total = toc (t0);
+  info.columns = n;
+  info.threads = 1;
+  info.utilization = 1;
+  if (accumulate)
+    fields = setdiff (fieldnames (info), {'threads', 'utilization'});
+    for i = 1:numel (fields)
+      totals.(fields{i}) = totals.(fields{i}) + info.(fields{i});
+    end
+    totals.threads = 1;
+    totals.utilization = 1;
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function info = newprofile ()
+
+  % Helper subfunction to create a structure of instrumentation counters and
+  % timings that are all zero
+  info = struct ('calls', 0, 'validation', 0, 'allocation', 0, 'copy', 0, ...
+                 'median', 0, 'newton', 0, 'total', 0, 'columns', 0, ...
+                 'iterations', 0, 'newton_steps', 0, 'bisection_steps', 0, ...
+                 'pairs', 0, 'failures', 0, 'threads', 0, 'utilization', 0, ...
+                 'bytes_allocated', 0);
+
+end
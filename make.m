@@ -88,7 +88,7 @@ else
   disp ('Attempting to compile the source code...');
   if isoctave
     try
-      mkoctfile -O3 -march=native --mex --output ./inst/boot ./src/boot.cpp
+      mkoctfile -O3 -fno-math-errno -fno-trapping-math --mex --output ./inst/boot ./src/boot.cpp
     catch
       errflag = true;
       err = lasterror();
@@ -96,7 +96,7 @@ else
       warning ('Could not compile boot.%s. Falling back to the (slower) boot.m file.', mexext)
     end
     try
-      mkoctfile -O3 -march=native --mex --output ./inst/smoothmedian ./src/smoothmedian.cpp
+      mkoctfile -O3 -fno-math-errno -fno-trapping-math -pthread --mex --output ./inst/smoothmedian ./src/smoothmedian.cpp
     catch
       errflag = true;
       err = lasterror();
@@ -112,7 +112,7 @@ else
       disp(err.message);
     end
     try
-      mex CXXFLAGS="$CXXFLAGS -O3 -march=native" -output ./inst/boot ./src/boot.cpp
+      mex CXXFLAGS="$CXXFLAGS -O3 -fno-math-errno -fno-trapping-math" -output ./inst/boot ./src/boot.cpp
     catch
       errflag = true;
       err = lasterror ();
@@ -120,7 +120,7 @@ else
       warning ('Could not compile boot.%s. Falling back to the (slower) boot.m file.', mexext)
     end
     try
-      mex CXXFLAGS="$CXXFLAGS -O3 -march=native" -output ./inst/smoothmedian ./src/smoothmedian.cpp
+      mex CXXFLAGS="$CXXFLAGS -O3 -fno-math-errno -fno-trapping-math -pthread" -output ./inst/smoothmedian ./src/smoothmedian.cpp
     catch
       errflag = true;
       err = lasterror();
@@ -20,7 +20,7 @@ n = 4;                          % Sample size
 nsamp = 1e+05;                  % Total sample size desired from simulation
 nsim = 1e+06;                   % Size of each simulation block
 eps = 5e-02 * sigma * sqrt (n); % Stringency/precision
-mu_good = [];
+ncpus = 0;                      % Number of parallel processes
 
 % Create random sample
 y = randn (n, 1) * sigma + mu; 
@@ -61,56 +61,58 @@ fprintf ('Population mean within range of sample (Is the prior valid?): %s\n', .
 fprintf ('Population mean within range of CI (Frequentist): %s\n',...
          LogicalStr{mu_within_range_of_CI + 1});
 fprintf ('Simulation size: %u\n', nsamp);
-fprintf ('Simulation progress:       ');
 
 
-% Perform simulation (in blocks of size nsim)
-count = 0;
-while (numel (mu_good) < nsamp)
-
-  % Update counter
-  count = count + 1;
-  fprintf (repmat ('\b', 1, 7));
-  fprintf ('% 6s%%', sprintf ('%.1f', round (1000 * numel (mu_good) / nsamp) / 10));
-  % Sample some mean values from the (flat) prior within 
-  % the range of the observed data (non-parametric)
-  %mu_sim = rand (1, nsim) * range + min (y); % Actual range (for prior == 1 only)
-  mu_sim = randn (1, nsim) * 2 * s + m; % Rule-of-thumb to estimate data 
-                                        % range from the standard deviation
-                                        % (use with prior == 1 or 'auto')
-
-  % Simulate data for each of these mean values with the same scale as the sample
-  if (skewflag)
-    Y = pearsrnd (0, s, g, 3, n, nsim); % 1st, 2nd and 3rd moment
-  else
-    Y = randn (n, nsim) * s;            % 1st and 2nd moment
+% Perform simulation in blocks of size nsim. The blocks are run (in parallel
+% if ncpus > 1) with independent random number streams by simrun, and each
+% returns the number of simulated means that match our "observed" data, and
+% how many of those lie within the CI.
+%  - Sample some mean values from the (flat) prior within the range of the
+%    observed data (non-parametric). Rule-of-thumb to estimate data range from
+%    the standard deviation (use with prior == 1 or 'auto'):
+mu_sim = @() randn (1, nsim) * 2 * s + m;
+%    (Actual range (for prior == 1 only): rand (1, nsim) * range + min (y))
+%  - Simulate data for each of these mean values with the same scale as the
+%    sample:
+if (skewflag)
+  Y_sim = @() pearsrnd (0, s, g, 3, n, nsim); % 1st, 2nd and 3rd moment
+else
+  Y_sim = @() randn (n, nsim) * s;            % 1st and 2nd moment
+end
+%  - Find simulated data that matches our "observed" data:
+match = @(mu, Y) all (abs (bsxfun (@minus, sort (bsxfun (@plus, Y, mu)), ...
+                                   sort (y))) <= eps);
+count = @(mu, i) [sum(i), sum (i & (CI(1) <= mu) & (mu <= CI(2)))];
+block = @(mu, Y) count (mu, match (mu, Y));
+out = zeros (0, 2);
+while (sum (out(:, 1)) < nsamp)
+  % Estimate the number of further blocks required from the blocks so far,
+  % running at most as many more blocks as have already been run
+  nblocks = size (out, 1);
+  k = max (1, ncpus);
+  if (nblocks > 0)
+    rate = max (sum (out(:, 1)), 1) / nblocks;
+    k = max (k, min (nblocks, ceil ((nsamp - sum (out(:, 1))) / rate)));
   end
-  Y = bsxfun (@plus, Y, mu_sim);
-
-  % Find simulated data that matches our "observed" data
-  Y = sort (Y);
-  y = sort (y);
-  i = all (abs (bsxfun (@minus, Y, y)) <= eps);
-  mu_good = cat (2, mu_good, mu_sim(i));
-
+  out = cat (1, out, simrun (@(i, seed) block (mu_sim (), Y_sim ()), ...
+                             nblocks + 1 : nblocks + k, 1, ncpus));
 end
 
-% Calculate statistics for Bayesian inference
-mu_good_within_CI = (CI(1) <= mu_good(1:nsamp)) & (mu_good(1:nsamp) <= CI(2));
+% Calculate statistics for Bayesian inference: the probability that the
+% population mean lies within the CI (Bayesian), with its Monte Carlo error
+nmatch = sum (out(:, 1));
+p = sum (out(:, 2)) / nmatch;
+se = sqrt (p * (1 - p) / nmatch);
 
 % Print results
-% Probability that population mean lies within the CI (Bayesian)'
-fprintf (repmat ('\b', 1, 7));
-fprintf ('% 6s%%', sprintf ('%.1f', 100));
 fprintf (['\n Our prior belief is that the location of the population\n',...
           ' mean is equally likely anywhere within the range of the data.\n',...
           ' Our updated belief (i.e. posterior) after non-parametric\n',...
           ' Bayesian bootstrap is summarized as a credible interval within\n',...
           ' which the population mean exists with effectively %.2f%%\n',...
-          ' probability (nominally %.1f%%).\n'],...
-          sum (mu_good_within_CI) / nsamp * 100, mass);
+          ' (MC error %.2f%%) probability (nominally %.1f%%).\n'],...
+          p * 100, se * 100, mass);
 % For application of Bayesian bootstrap in linear regression, the prior is
 % that the location of the population parameter is equally likely anywhere
 % within the support of the data (for example, within the range of
 % possible parameter values in a set of bootstrap resamples).
-
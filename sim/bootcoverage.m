@@ -0,0 +1,258 @@
+% Evaluates the coverage, tail probabilities, length and shape of bootstrap
+% confidence intervals by Monte Carlo simulation
+%
+% -- Function File: RESULTS = bootcoverage (RND, BOOTFUN, THETA, N)
+% -- Function File: RESULTS = bootcoverage (..., NAME, VALUE)
+% -- Function File: bootcoverage (...)
+%
+%     'RESULTS = bootcoverage (RND, BOOTFUN, THETA, N)' simulates datasets of
+%     size N by calling the function handle RND (N), computes a confidence
+%     interval for the statistic BOOTFUN from each dataset, and summarizes how
+%     well the intervals cover the true value of the parameter, THETA. The
+%     replicates are run by simrun, so each dataset is drawn from its own
+%     random number stream and the results do not depend on the number of
+%     processes (but see 'seed' below). RESULTS is a structure with the following fields, each of
+%     which (except for sim) is a structure with the fields 'estimate' and
+%     'mcse' (the Monte Carlo standard error of the estimate):
+%        o sim: the number of simulated datasets
+%        o coverage: the proportion of intervals that contain THETA
+%        o below: the proportion of intervals whose lower bound is above THETA
+%        o above: the proportion of intervals whose upper bound is below THETA
+%        o length: the mean length of the intervals
+%        o median_length: the median length of the intervals
+%        o shape: the median of the ratio of the distances from the estimate
+%          to the upper and lower bounds (1 for symmetric intervals)
+%     If no output is requested, the results are printed instead.
+%
+%     'RESULTS = bootcoverage (..., NAME, VALUE)' sets the following options:
+%        o 'nvar': the number of data variables, each drawn by a separate call
+%              to RND and passed to BOOTFUN (e.g. 2 for a correlation).
+%              Default is 1.
+%        o 'sim': the number of simulated datasets. Default is 1000.
+%        o 'nboot': the number of bootstrap resamples (or, for bootknife, a
+%              pair [B, C] for the double bootstrap). Default is 1999.
+%        o 'alpha': as for bootknife, the significance level (e.g. 0.05) for
+%              a two-sided interval, or a pair of probabilities for the lower
+%              and upper bounds. Default is 0.05.
+%        o 'method': the function used to compute each interval:
+%              'percentile' (fast path: percentile interval from balanced
+%                   resamples drawn by boot, with BOOTFUN evaluated on all
+%                   of them in a single call, so BOOTFUN must be vectorized
+%                   to operate on each column of its input(s))
+%              'bootclust' (default, as bootclust with bootknife resampling
+%                   disabled)
+%              'bootknife' (bias-corrected and accelerated, or calibrated for
+%                   the double bootstrap)
+%              'bootwild' and 'bootbayes' (intervals for the mean; BOOTFUN is
+%                   only used to compute the estimate)
+%        o 'seed': the seed for the random number streams (see simrun).
+%              Default is 1. The resampling is also seeded from the stream of
+%              each replicate, so the results are reproducible and do not
+%              depend on the number of processes. The exception is the inner
+%              layer of resampling of the double bootstrap (bootknife with
+%              NBOOT = [B, C]), which is only reproducible with the boot
+%              m-file, since the boot MEX file seeds each of the inner calls
+%              to boot from the system's random device.
+%        o 'ncpus': the number of parallel processes. Default is 0 (serial).
+%        o 'checkpoint': the name of a MAT-file used to save progress so that
+%              an interrupted simulation can be resumed (see simrun).
+%
+%  bootcoverage (version 2026.10.17)
+%  Author: Andrew Charles Penn
+%  https://www.researchgate.net/profile/Andrew_Penn/
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function results = bootcoverage (rnd, bootfun, theta, n, varargin)
+
+  % Check input arguments
+  if (nargin < 4)
+    error ('bootcoverage: RND, BOOTFUN, THETA and N must be provided')
+  end
+  if (~ isa (rnd, 'function_handle') || ~ isa (bootfun, 'function_handle'))
+    error ('bootcoverage: RND and BOOTFUN must be function handles')
+  end
+
+  % Set default values for the options
+  opt = struct ('nvar', 1, 'sim', 1000, 'nboot', 1999, 'alpha', 0.05, ...
+                'method', 'bootclust', 'seed', 1, 'ncpus', 0, ...
+                'checkpoint', []);
+
+  % Evaluate the options
+  if (mod (numel (varargin), 2))
+    error ('bootcoverage: Options must be provided as NAME, VALUE pairs')
+  end
+  for i = 1:2:numel (varargin)
+    name = lower (varargin{i});
+    if (~ isfield (opt, name))
+      error ('bootcoverage: Unrecognised option: %s', varargin{i})
+    end
+    opt.(name) = varargin{i + 1};
+  end
+  opt.method = lower (opt.method);
+  if (~ ismember (opt.method, {'percentile', 'bootclust', 'bootknife', ...
+                               'bootwild', 'bootbayes'}))
+    error ('bootcoverage: Unrecognised method: %s', opt.method)
+  end
+
+  % Run the simulation
+  out = simrun (@(i, s) replicate (rnd, bootfun, n, s, opt), opt.sim, ...
+                opt.seed, opt.ncpus, opt.checkpoint);
+  stat = out(:, 1);
+  ci = out(:, 2:3);
+
+  % Summarize the intervals
+  sim = size (out, 1);
+  inside = (theta >= ci(:, 1)) & (theta <= ci(:, 2));
+  len = ci(:, 2) - ci(:, 1);
+  shape = (ci(:, 2) - stat) ./ (stat - ci(:, 1));
+  results = struct;
+  results.sim = sim;
+  results.coverage = proportion (inside);
+  results.below = proportion (theta < ci(:, 1));
+  results.above = proportion (theta > ci(:, 2));
+  results.length = struct ('estimate', mean (len), ...
+                           'mcse', std (len) / sqrt (sim));
+  results.median_length = struct ('estimate', median (len), ...
+                                  'mcse', quantse (len, 0.5));
+  results.shape = struct ('estimate', median (shape), ...
+                          'mcse', quantse (shape, 0.5));
+
+  % Print the results
+  if (nargout < 1)
+    fprintf (cat (2, '%s: %.1f%% (MC error %.1f%%)\n', ...
+                     '%s: %.4f (MC error %.4f)\n', ...
+                     '%s: %.4f (MC error %.4f)\n', ...
+                     '%s: %.4f (MC error %.4f)\n', ...
+                     '%s: %.4f (MC error %.4f)\n', ...
+                     '%s: %.4f (MC error %.4f)\n'), ...
+             'Coverage', 100 * results.coverage.estimate, ...
+                         100 * results.coverage.mcse, ...
+             'Lower tail rejection', results.below.estimate, ...
+                                     results.below.mcse, ...
+             'Upper tail rejection', results.above.estimate, ...
+                                     results.above.mcse, ...
+             'Length (mean)', results.length.estimate, results.length.mcse, ...
+             'Length (median)', results.median_length.estimate, ...
+                                results.median_length.mcse, ...
+             'Shape (median)', results.shape.estimate, results.shape.mcse);
+    clear results
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function y = replicate (rnd, bootfun, n, s, opt)
+
+  % Helper subfunction to simulate a dataset and return the estimate and the
+  % confidence interval
+  data = cell (1, opt.nvar);
+  for v = 1:opt.nvar
+    data{v} = rnd (n);
+  end
+  stat = bootfun (data{:});
+  switch (opt.method)
+    case 'percentile'
+      % Fast path: evaluate BOOTFUN on all of the resamples in a single call
+      bootsam = boot (n, opt.nboot(1), false, s);
+      resamples = cellfun (@(x) x(bootsam), data, 'UniformOutput', false);
+      bootstat = bootfun (resamples{:});
+      if (numel (opt.alpha) > 1)
+        probs = opt.alpha;
+      else
+        probs = [opt.alpha / 2, 1 - opt.alpha / 2];
+      end
+      ci = quantile (bootstat(:), probs);
+    case 'bootclust'
+      if (opt.nvar > 1)
+        S = bootclust (data, opt.nboot(1), bootfun, opt.alpha, [], false, s);
+      else
+        S = bootclust (data{1}, opt.nboot(1), bootfun, opt.alpha, [], false, s);
+      end
+      ci = [S.CI_lower, S.CI_upper];
+    case 'bootknife'
+      % Draw the (outer) bootknife resamples with the seed of the replicate
+      bootsam = boot (n, opt.nboot(1), true, s);
+      if (opt.nvar > 1)
+        S = bootknife (data, opt.nboot, bootfun, opt.alpha, [], 0, bootsam);
+      else
+        S = bootknife (data{1}, opt.nboot, bootfun, opt.alpha, [], 0, bootsam);
+      end
+      ci = [S.CI_lower, S.CI_upper];
+    case 'bootwild'
+      S = bootwild (data{1}, [], [], opt.nboot(1), opt.alpha, s);
+      ci = [S.CI_lower, S.CI_upper];
+    case 'bootbayes'
+      if (numel (opt.alpha) > 1)
+        prob = opt.alpha;
+      else
+        prob = 1 - opt.alpha;
+      end
+      S = bootbayes (data{1}, [], [], opt.nboot(1), prob, [], s);
+      ci = [S.CI_lower, S.CI_upper];
+  end
+  y = [stat, ci(1), ci(2)];
+
+end
+
+%--------------------------------------------------------------------------
+
+function S = proportion (x)
+
+  % Helper subfunction to return a proportion and its Monte Carlo error
+  p = mean (x);
+  S = struct ('estimate', p, 'mcse', sqrt (p * (1 - p) / numel (x)));
+
+end
+
+%--------------------------------------------------------------------------
+
+function se = quantse (x, q)
+
+  % Helper subfunction to return the Monte Carlo standard error of the q-th
+  % quantile of x, from the order statistics at +/- 1 binomial standard error
+  x = sort (x(~ isnan (x)));
+  B = numel (x);
+  if (B < 2)
+    se = NaN;
+    return
+  end
+  d = sqrt (B * q * (1 - q));
+  lo = max (1, min (B, round (B * q - d)));
+  hi = max (1, min (B, round (B * q + d)));
+  se = (x(hi) - x(lo)) / 2;
+
+end
+
+%!test
+%! % Test that the results are reproducible
+%! rnd = @(n) randn (n, 1);
+%! R1 = bootcoverage (rnd, @mean, 0, 10, 'sim', 20, 'nboot', 199, ...
+%!                    'method', 'percentile');
+%! R2 = bootcoverage (rnd, @mean, 0, 10, 'sim', 20, 'nboot', 199, ...
+%!                    'method', 'percentile');
+%! assert (R1, R2);
+%! assert (R1.sim, 20);
+%! assert (R1.coverage.mcse, sqrt (R1.coverage.estimate * ...
+%!                                 (1 - R1.coverage.estimate) / 20), 1e-12);
+%!
+%! % The bootknife resamples are also drawn from the stream of each replicate
+%! R1 = bootcoverage (rnd, @mean, 0, 10, 'sim', 5, 'nboot', 199, ...
+%!                    'method', 'bootknife');
+%! R2 = bootcoverage (rnd, @mean, 0, 10, 'sim', 5, 'nboot', 199, ...
+%!                    'method', 'bootknife');
+%! assert (R1, R2);
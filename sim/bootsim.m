@@ -41,16 +41,21 @@ n = 7;
 % Define number of simulations
 sim = 1000;
 
-% Reset outcome counters
-accept = 0;
-reject = 0;
-above = 0;
-below = 0;
-
 % Bootstrap resampling
 %nboot = [1999,199];
 nboot = 1999;
-type = 'bca';
+
+% Method used to compute each interval (see help for bootcoverage):
+% 'percentile' (fast path for vectorized bootfun), 'bootclust', 'bootknife',
+% 'bootwild' or 'bootbayes'
+method = 'bootclust';
+
+% Parallel processing (replicates are run with independent random number
+% streams, so the results do not depend on ncpus)
+ncpus = 0;
+
+% Checkpoint file for resuming an interrupted simulation (or [] for none)
+checkpoint = [];
 
 % Print settings
 fprintf ('----- BOOTSTRAP CONFIDENCE INTERVAL (CI) SIMULATION -----\n')
@@ -58,90 +63,13 @@ fprintf ('Simulation size: %u\n',sim);
 fprintf ('Sample size: %u\n',n);
 fprintf ('nboot: %u\n',nboot);
 fprintf ('Statistic: %s\n',char(bootfun));
+fprintf ('Method: %s\n',method);
 fprintf ('Alpha: %.3f\n',alpha);
 
-% Initialize simulation variables
-length = nan (sim,1);
-shape  = nan (sim,1);
-coverage  = nan (sim,1);
-
-% Parallel processing
-ncpus = 1;
-paropt = struct ('UseParallel', true, 'nproc', ncpus);
-  
-% Start simulation
-for i=1:sim
-
-  % Create random sample
-  x = rnd (n);
-  if (nvar > 1)
-    y = rnd (n);
-  end
-
-  % Calculate statistic from the sample
-  if (nvar > 1)
-    stat = feval (bootfun, x, y);
-  else
-    stat = feval (bootfun, x);
-  end
-  
-  % Bootstrap confidence interval
-  %ci = bootci (nboot(1), {bootfun,x}, 'alpha', alpha, 'type', type, 'Options', paropt);
-  if (nvar > 1)
-    %S = bootknife ({x, y}, nboot, bootfun, alpha, [], ncpus); ci = [S.CI_lower; S.CI_upper];
-    S = bootclust ({x, y}, nboot, bootfun, alpha, [], false); ci = [S.CI_lower; S.CI_upper];
-  else
-    %S = bootknife (x, nboot, bootfun, alpha, [], ncpus); ci = [S.CI_lower; S.CI_upper];
-    S = bootclust (x, nboot, bootfun, alpha, [], false); ci = [S.CI_lower; S.CI_upper];
-    %S = bootbayes (x, [], [], nboot(1), [alpha/2, 1 - alpha/2]); ci=[S.CI_lower,S.CI_upper];
-    %S = bootwild (x, [], [], nboot(1)); ci=[S.CI_lower,S.CI_upper];
-  end
-
-  % Coverage counter
-  if (theta >= ci(1) && theta <= ci(2))
-   accept = accept + 1;
-  else
-   reject = reject + 1;
-  end
-  %if (S.pval > alpha)
-  % accept = accept + 1;
-  %else
-  % reject = reject + 1;
-  %end
-  if (theta < ci(1))
-    below = below + 1;
-  elseif (theta > ci(2))
-    above = above + 1;
-  end
-  coverage (i) = accept / (accept + reject);
-  if (i > 1)
-    fprintf (repmat ('\b', 1, 14))
-  end
-  fprintf ('%s: % 5s%s',...
-          sprintf ('%06d', i),...
-          sprintf ('%.1f', round (1000 * coverage(i)) / 10),'%');
-
-  % Interval lengths
-  length (i) = ci(2) - ci(1);
-
-  % Interval shape
-  shape (i) = (ci(2) - stat) / (stat - ci(1));
-
-end
-
-% Print results
-fprintf (repmat('\b', 1, 14))
-fprintf (['%s: %.1f%s\n',...
-          '%s: %.2f (%.2f-%.2f)\n',...
-          '%s: %.2f (%.2f-%.2f)\n',...
-          '%s: %.4f\n',...
-          '%s: %.4f\n',...
-          '%s: %.4f\n'],...
-           'Coverage',100 * coverage(end),'%',...
-           'Length', median (length), quantile (length,0.25), quantile (length, 0.75),...
-           'Shape', median (shape), quantile (shape,0.25), quantile (shape, 0.75),...
-           'Lower tail rejection', below / sim,...
-           'Upper tail rejection', above / sim);
+% Run the simulation and print the results with their Monte Carlo error
+bootcoverage (rnd, bootfun, theta, n, 'nvar', nvar, 'sim', sim, ...
+              'nboot', nboot, 'alpha', alpha, 'method', method, ...
+              'ncpus', ncpus, 'checkpoint', checkpoint);
 
 % Restore initial warning states
 warning (state);
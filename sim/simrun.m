@@ -0,0 +1,203 @@
+% Runs the replicates of a Monte Carlo simulation, in parallel if requested,
+% with an independent random number stream for each replicate
+%
+% -- Function File: OUT = simrun (FUN, NREPS)
+% -- Function File: OUT = simrun (FUN, REPS)
+% -- Function File: OUT = simrun (..., SEED)
+% -- Function File: OUT = simrun (..., SEED, NCPUS)
+% -- Function File: OUT = simrun (..., SEED, NCPUS, CHECKPOINT)
+%
+%     'OUT = simrun (FUN, NREPS)' evaluates FUN (I, S) for each replicate
+%     I = 1, ..., NREPS and returns the results in the rows of OUT. FUN must
+%     return a numeric row vector of the same length for every replicate.
+%     Before each evaluation, the random number generators used by rand and
+%     randn (and therefore random etc.) are set to a stream that is unique to
+%     the replicate, so that the results do not depend on the order in which
+%     the replicates are evaluated, or on the number of processes. S is a
+%     positive integer seed drawn from that stream, which FUN can pass on to
+%     the functions of this package that accept a SEED for resampling.
+%
+%     'OUT = simrun (FUN, REPS)' evaluates FUN for each replicate index in the
+%     vector REPS (e.g. to continue a simulation with more replicates).
+%
+%     'OUT = simrun (..., SEED)' sets the seed (a non-negative integer) from
+%     which the random number streams of the replicates are derived. The
+%     default value of SEED is 1. In Octave, the stream of replicate I is the
+%     Mersenne Twister initialized with the key [SEED, I] (or [SEED, I, 1] for
+%     randn). In Matlab, it is substream I of the combined multiple recursive
+%     generator (mrg32k3a) with seed SEED, which are guaranteed to be
+%     independent.
+%
+%     'OUT = simrun (..., SEED, NCPUS)' evaluates the replicates in parallel
+%     using NCPUS processes, using the parallel package in Octave or the
+%     Parallel Computing Toolbox in Matlab. The default value of NCPUS is 0
+%     (i.e. serial evaluation).
+%
+%     'OUT = simrun (..., SEED, NCPUS, CHECKPOINT)' saves the results of
+%     completed replicates to the MAT-file CHECKPOINT, at most once a minute.
+%     If CHECKPOINT already exists (e.g. after the simulation was interrupted)
+%     and was saved for the same REPS and SEED, the simulation resumes from the
+%     saved results. CHECKPOINT is deleted when the simulation is complete.
+%
+%  simrun (version 2026.10.17)
+%  Author: Andrew Charles Penn
+%  https://www.researchgate.net/profile/Andrew_Penn/
+%
+%  Copyright 2019 Andrew Charles Penn
+%  This program is free software: you can redistribute it and/or modify
+%  it under the terms of the GNU General Public License as published by
+%  the Free Software Foundation, either version 3 of the License, or
+%  (at your option) any later version.
+%
+%  This program is distributed in the hope that it will be useful,
+%  but WITHOUT ANY WARRANTY; without even the implied warranty of
+%  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+%  GNU General Public License for more details.
+%
+%  You should have received a copy of the GNU General Public License
+%  along with this program.  If not, see http://www.gnu.org/licenses/
+
+
+function out = simrun (fun, reps, seed, ncpus, checkpoint)
+
+  % Check input arguments
+  if (nargin < 2)
+    error ('simrun: FUN and NREPS must be provided')
+  end
+  if (~ isa (fun, 'function_handle'))
+    error ('simrun: FUN must be a function handle')
+  end
+  if (isscalar (reps))
+    reps = 1 : reps;
+  end
+  reps = reps(:)';
+  if (isempty (reps) || any (reps ~= abs (fix (reps))) || any (reps < 1))
+    error ('simrun: NREPS or REPS must contain positive integers')
+  end
+  if ((nargin < 3) || isempty (seed))
+    seed = 1;
+  end
+  if (~ isscalar (seed) || (seed ~= abs (fix (seed))))
+    error ('simrun: SEED must be a non-negative integer')
+  end
+  if ((nargin < 4) || isempty (ncpus))
+    ncpus = 0;
+  end
+  if ((nargin < 5) || isempty (checkpoint))
+    checkpoint = [];
+  elseif (~ ischar (checkpoint))
+    error ('simrun: CHECKPOINT must be a file name')
+  end
+
+  % Check if running in Octave (else assume Matlab)
+  info = ver;
+  ISOCTAVE = any (ismember ({info.Name}, 'Octave'));
+
+  % If applicable, check we have parallel computing capabilities
+  if (ncpus > 1)
+    if (ISOCTAVE)
+      software = pkg ('list');
+      names = cellfun (@(S) S.name, software, 'UniformOutput', false);
+      status = cellfun (@(S) S.loaded, software, 'UniformOutput', false);
+      index = find (~ cellfun (@isempty, regexpi (names, '^parallel')));
+      PARALLEL = (~ isempty (index)) && logical (status{index});
+    else
+      PARALLEL = ismember ('Parallel Computing Toolbox', {info.Name});
+    end
+    if (~ PARALLEL)
+      warning ('simrun:parallel', ...
+               'Parallel processing is not available. Falling back to serial.')
+      ncpus = 0;
+    end
+  end
+
+  % Resume from the checkpoint, if there is one
+  nreps = numel (reps);
+  out = [];
+  done = 0;
+  if (~ isempty (checkpoint) && exist (checkpoint, 'file'))
+    chkpt = load (checkpoint);
+    if (~ isequal (chkpt.reps, reps) || (chkpt.seed ~= seed))
+      error (cat (2, 'simrun: CHECKPOINT was saved for a different', ...
+                     ' simulation'))
+    end
+    out = chkpt.out;
+    done = chkpt.done;
+  end
+
+  % Evaluate the replicates in chunks of about 1% of the simulation, so that
+  % progress can be reported and saved between chunks
+  chunk = max (max (1, ncpus), ceil (nreps / 100));
+  lastsave = tic;
+  msg = '';
+  while (done < nreps)
+    j = done + 1 : min (done + chunk, nreps);
+    if (ncpus > 1)
+      if (ISOCTAVE)
+        res = parcellfun (ncpus, @(i) runone (fun, i, seed, ISOCTAVE), ...
+                          num2cell (reps(j)), 'UniformOutput', false, ...
+                          'VerboseLevel', 0);
+      else
+        res = cell (1, numel (j));
+        r = reps(j);
+        parfor k = 1 : numel (j)
+          res{k} = runone (fun, r(k), seed, ISOCTAVE);
+        end
+      end
+    else
+      res = arrayfun (@(i) runone (fun, i, seed, ISOCTAVE), reps(j), ...
+                      'UniformOutput', false);
+    end
+    out(j, :) = cell2mat (res(:));
+    done = j(end);
+
+    % Report progress
+    fprintf (repmat ('\b', 1, numel (msg)));
+    msg = sprintf ('Simulation progress: %5.1f%%', 100 * done / nreps);
+    fprintf ('%s', msg);
+
+    % Save the results at most once a minute
+    if (~ isempty (checkpoint) && (done < nreps) && (toc (lastsave) > 60))
+      chkpt = struct ('reps', reps, 'seed', seed, 'out', out, 'done', done);
+      savecheckpoint (checkpoint, chkpt);
+      lastsave = tic;
+    end
+  end
+  fprintf ('\n');
+  if (~ isempty (checkpoint) && exist (checkpoint, 'file'))
+    delete (checkpoint);
+  end
+
+end
+
+%--------------------------------------------------------------------------
+
+function y = runone (fun, i, seed, ISOCTAVE)
+
+  % Helper subfunction to evaluate a replicate with its own random number
+  % stream
+  if (ISOCTAVE)
+    rand ('twister', [seed; i]);
+    randn ('twister', [seed; i; 1]);
+  else
+    stream = RandStream ('mrg32k3a', 'Seed', seed);
+    stream.Substream = i;
+    RandStream.setGlobalStream (stream);
+  end
+  s = fix (rand * (2^31 - 2)) + 1;
+  y = fun (i, s);
+  y = y(:)';
+
+end
+
+%--------------------------------------------------------------------------
+
+function savecheckpoint (checkpoint, chkpt)
+
+  % Write the checkpoint to a temporary file before replacing the previous one
+  % so that an interruption while saving cannot corrupt the CHECKPOINT file
+  tmpfile = cat (2, checkpoint, '.tmp');
+  save (tmpfile, '-struct', 'chkpt', '-v7');
+  movefile (tmpfile, checkpoint, 'f');
+
+end
@@ -12,6 +12,9 @@
 // BOOTSAM = boot (..., NBOOT, LOO)
 // BOOTSAM = boot (..., NBOOT, LOO, SEED)
 // BOOTSAM = boot (..., NBOOT, LOO, SEED, WEIGHTS)
+// boot (..., NBOOT, LOO, SEED, WEIGHTS, FILENAME)
+// [BOOTSAM, INFO] = boot (...)
+// INFO = boot ('profile')
 //
 // INPUT VARIABLES
 // N (double) is the number of rows (of the data vector)
@@ -21,10 +24,13 @@
 //   (for bootknife)
 // SEED (double) is a seed used to initialise the pseudo-random number generator
 // WEIGHTS (double) is a weight vector of length N
+// FILENAME (char) is the name of a file to write BOOTSAM to
 //
 // OUTPUT VARIABLE
 // BOOTSAM (double) is an N x NBOOT matrix of sample indices (N) or NBOOT 
-//   columns of resampled data (X)
+//   columns of resampled data (X), which is empty (0 x NBOOT) if N is 0 or X
+//   is empty
+// INFO (struct) contains instrumentation counters and timings (see below)
 //
 // NOTES
 // LOO is an optional input argument. The default is false. If LOO is true
@@ -43,36 +49,131 @@
 // weighting). Each element of WEIGHTS is the number of times that the
 // corresponding index is represented in bootsam. Therefore, the sum of WEIGHTS
 // should equal N * NBOOT. 
+// FILENAME is an optional input argument. If FILENAME is provided, BOOTSAM is
+// written to the file one column at a time (see bootwrite for the format)
+// instead of being returned, so the whole of BOOTSAM is never held in memory.
+// Sample indices are stored as unsigned integers of the smallest width (8, 16
+// or 32 bits) that can hold N. Resampled data values are stored as doubles.
 //
 // Compared to previous versions (in package versions <=5.6.0), the boot.mex 
 // function is now thread safe.
 //
+// If a second output (INFO) is requested, the call is instrumented and INFO is
+// a structure with the following fields: calls (the number of calls profiled),
+// the time (in seconds) spent on validation of the input arguments, allocation
+// of the output (or opening of FILENAME), drawing random numbers (rng),
+// searching for the sampled indices and putting them in BOOTSAM (search),
+// writing to FILENAME (write) and in total, the number of random draws
+// (draws), the number of steps of the linear search (search_steps), and the
+// number of bytes allocated and written to FILENAME. The rng and search
+// timings include the overhead of reading the clock for every draw.
+// If the environment variable STATISTICS_RESAMPLING_PROFILE is set (to a value
+// other than 0), every call is instrumented and the counters and timings are
+// added to running totals, which are returned (and then reset) by
+// INFO = boot ('profile'). This can be used to attribute the time spent in
+// boot by functions that call it, such as bootknife and bootlm.
+//
+// The resampling engine and the file format are implemented in boot.h, which
+// can be used without the MEX API.
+//
 // Requirements: Compilation requires C++11
 //
 // Author: Andrew Charles Penn (2022)
 
 #include "mex.h"
+#include "boot.h"           // for the resampling engine and file format
 #include <vector>
 #include <random>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>          // for getenv function
+#include <cstring>          // for strcmp function
+#include <chrono>           // for steady_clock
+#include <memory>           // for unique_ptr
+#include <stdexcept>        // for exception
+#include <string>
 using namespace std;
+using namespace resampling;
+
+
+// Instrumentation counters and timings of one or more calls
+struct Profile {
+    double calls, validation, allocation, write, total, bytes_allocated,
+           bytes_written;
+    BootProfile sampler;
+    Profile () : calls (0), validation (0), allocation (0), write (0),
+                 total (0), bytes_allocated (0), bytes_written (0) {}
+};
+
+// Running totals of the calls profiled since they were last returned
+static Profile totals;
+
+static bool profile_env (void) {
+    const char *env = getenv ("STATISTICS_RESAMPLING_PROFILE");
+    return ( env != 0 && env[0] != '\0' && strcmp (env, "0") != 0 );
+}
+
+static double seconds_since (chrono::steady_clock::time_point t0) {
+    return chrono::duration<double> (chrono::steady_clock::now () - t0).count ();
+}
+
+static mxArray *profile_struct (const Profile &p) {
+    const char *fields[] = {"calls", "validation", "allocation", "rng",
+                            "search", "write", "total", "draws",
+                            "search_steps", "bytes_allocated", "bytes_written"};
+    const double vals[] = {p.calls, p.validation, p.allocation, p.sampler.rng,
+                           p.sampler.search, p.write, p.total,
+                           (double) p.sampler.draws, (double) p.sampler.steps,
+                           p.bytes_allocated, p.bytes_written};
+    const int nfields = sizeof (fields) / sizeof (fields[0]);
+    mxArray *s = mxCreateStructMatrix (1, 1, nfields, fields);
+    for ( int i = 0; i < nfields; i++ ) {
+        mxSetField (s, 0, fields[i], mxCreateDoubleScalar (vals[i]));
+    }
+    return s;
+}
 
 
 void mexFunction (int nlhs, mxArray* plhs[],
                   int nrhs, const mxArray* prhs[]) 
 {
 
+    // Return (and reset) the running totals of the instrumentation
+    if ( nrhs == 1 && mxIsChar (prhs[0]) ) {
+        char *str = mxArrayToString (prhs[0]);
+        bool isprofile = ( strcmp (str, "profile") == 0 );
+        mxFree (str);
+        if ( !isprofile ) {
+            mexErrMsgTxt ("The only valid string input argument is 'profile'.");
+        }
+        if ( nlhs > 1 ) {
+            mexErrMsgTxt ("Too many output arguments.");
+        }
+        plhs[0] = profile_struct (totals);
+        totals = Profile ();
+        return;
+    }
+
+    // Start the clock if the call is to be instrumented
+    const bool profiling = ( nlhs > 1 || profile_env () );
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now ();
+    chrono::steady_clock::time_point t1;
+    Profile prof;
+
     // Input variables
     if ( nrhs < 2 ) {
         mexErrMsgTxt ("At least two input arguments are required.");
     }
-    if ( nrhs > 5) {
+    if ( nrhs > 6) {
         mexErrMsgTxt ("Too many input arguments.");
     } 
     // First input argument (n or x)
     double *x = (double *) mxGetData (prhs[0]);
     size_t n = mxGetNumberOfElements (prhs[0]);
     bool isvec;
-    if ( n > 1 ) {
+    if ( n == 0 ) {
+        isvec = false;
+    } else if ( n > 1 ) {
         const mwSize *sz = mxGetDimensions (prhs[0]);
         if ( sz[0] > 1 && sz[1] > 1 ) {
             mexErrMsgTxt ("The first input argument must be either a scalar (N) or vector (X).");
@@ -140,23 +241,26 @@ void mexFunction (int nlhs, mxArray* plhs[],
     }
     // Fifth input argument (w, weights)
     // Error checking is handled later (see below in 'Declare variables' section) 
+    // Sixth input argument (filename)
+    bool tofile = false;
+    if ( nrhs > 5 && !mxIsEmpty (prhs[5]) ) {
+        if ( !mxIsChar (prhs[5]) ) {
+            mexErrMsgTxt ("The sixth input argument (FILENAME) must be a character array.");
+        }
+        tofile = true;
+    }
 
     // Output variables
-    if (nlhs > 1) {
+    if (nlhs > 2) {
         mexErrMsgTxt ("Too many output arguments.");
     }
+    if (tofile && nlhs == 1) {
+        mexErrMsgTxt ("BOOTSAM is not returned when it is written to FILENAME.");
+    }
 
-    // Declare variables
-    mwSize dims[2] = {static_cast<mwSize>(n), static_cast<mwSize>(nboot)};
-    plhs[0] = mxCreateNumericArray (2, dims, 
-                mxDOUBLE_CLASS, 
-                mxREAL);               // Prepare array for sample indices
-    size_t N = n * nboot;              // Total counts of all sample indices
-    size_t k;                          // Variable to store random number
-    long long int d;                   // Counter for cumulative sum calculation
-    vector<long long int> c(n, nboot); // Counter for each of the sample indices
+    // Assign user defined weights (counts)
+    vector<long long int> c;
     if ( nrhs > 4 && !mxIsEmpty (prhs[4]) ) {
-        // Assign user defined weights (counts)
         if ( !mxIsClass (prhs[4], "double") ) {
             mexErrMsgTxt ("The fifth input argument (WEIGHTS) must be of type double.");
         }
@@ -167,6 +271,7 @@ void mexFunction (int nlhs, mxArray* plhs[],
         if ( mxGetNumberOfElements (prhs[4]) != n ) {
             mexErrMsgTxt ("WEIGHTS must be a vector of length N or be the same length as X.");
         }
+        c.resize (n);
         long long int s = 0; 
         for ( size_t i = 0; i < n ; i++ )  {
             if ( !mxIsFinite (w[i]) ) {
@@ -178,66 +283,141 @@ void mexFunction (int nlhs, mxArray* plhs[],
             c[i] = w[i]; // Set each element in c to the specified weight    
             s += c[i];
         }
-        if ( s != N ) {
+        if ( s != (long long int) (n * nboot) ) {
             mexErrMsgTxt ("The elements of WEIGHTS must sum to N * NBOOT.");
         }
+        prof.bytes_allocated += n * sizeof (long long int);
     }
-    long long int m = 0;            // Counter for LOO sample index r
-    long long int r = -1;           // Sample index for LOO
 
-    // Create pointer so that we can access elements of bootsam (i.e. plhs[0])
-    double *ptr = (double *) mxGetData(plhs[0]);
+    // Create the resampling engine before any output is prepared (or FILENAME
+    // is opened). If N is zero, BOOTSAM is an empty (0 x NBOOT) matrix and no
+    // engine is needed. Exceptions must not escape the MEX function, so any
+    // error is caught and raised by mexErrMsgTxt once the handler has exited.
+    unique_ptr<BalancedSampler> sampler;
+    string err;
+    if ( n > 0 ) {
+        try {
+            sampler.reset (new BalancedSampler (n, nboot, loo, seed, c));
+            prof.bytes_allocated += n * sizeof (long long int);
+        } catch (const exception &e) {
+            err = e.what ();
+        }
+        if ( !err.empty () ) {
+            mexErrMsgTxt (err.c_str ());
+        }
+    }
+    if ( profiling ) {
+        prof.validation = seconds_since (t0);
+        t1 = chrono::steady_clock::now ();
+    }
 
-    // Initialize pseudo-random number generator (Mersenne Twister 19937)
-    mt19937_64 rng (seed);
-    uniform_int_distribution<size_t> distr (0, n - 1);
-    uniform_int_distribution<size_t> distk (0, N - 1);
+    // Prepare the output. Columns of bootsam are either generated in place in
+    // the returned array (plhs[0]), or in a buffer that is written to the file
+    double *ptr = NULL;
+    vector<double> buf;
+    FILE *fid = NULL;
+    uint32_t type = BOOTMAT_DOUBLE;
+    if ( tofile ) {
+        if ( !isvec ) {
+            type = bootmat_index_type (n);
+        }
+        char *filename = mxArrayToString (prhs[5]);
+        fid = fopen (filename, "wb");
+        mxFree (filename);
+        if ( fid == NULL ) {
+            mexErrMsgTxt ("Could not open FILENAME for writing.");
+        }
+        if ( !write_bootmat_header (fid, type, n, nboot) ) {
+            fclose (fid);
+            mexErrMsgTxt ("Could not write to FILENAME.");
+        }
+        buf.resize (n);
+        prof.bytes_allocated += n * sizeof (double);
+        prof.bytes_written += 32;
+        if ( nlhs > 0 ) {
+            plhs[0] = mxCreateDoubleMatrix (0, 0, mxREAL);
+        }
+    } else {
+        mwSize dims[2] = {static_cast<mwSize>(n), static_cast<mwSize>(nboot)};
+        plhs[0] = mxCreateNumericArray (2, dims, 
+                    mxDOUBLE_CLASS, 
+                    mxREAL);           // Prepare array for sample indices
+        ptr = (double *) mxGetData (plhs[0]);
+        prof.bytes_allocated += (double) n * nboot * sizeof (double);
+    }
+    vector<size_t> idx;
+    if ( isvec ) {
+        // Sample indices of each resample, from which the values are gathered
+        idx.resize (n);
+        prof.bytes_allocated += n * sizeof (size_t);
+    }
+    if ( profiling ) {
+        prof.allocation = seconds_since (t1);
+        if ( sampler ) sampler->set_profile (&prof.sampler);
+    }
 
-    // Perform balanced sampling
-    for ( size_t b = 0; b < nboot ; b++ ) { 
-        if ( loo == true ) {
-            // Note that the following division operations are for integers 
-            if ( (b / n) == (nboot / n) ) {
-                r = distr (rng);      // random
+    // Perform balanced sampling (there is nothing to draw if N is zero)
+    const size_t width = ( type == BOOTMAT_UINT8 ) ? 1 :
+                         ( type == BOOTMAT_UINT16 ) ? 2 :
+                         ( type == BOOTMAT_UINT32 ) ? 4 : 8;
+    for ( size_t b = 0; sampler && b < nboot ; b++ ) { 
+        double *col = tofile ? buf.data () : ptr + b * n;
+        try {
+            if (isvec) {
+                sampler->next (idx.data ());
+                gather (col, x, idx.data (), n);
             } else {
-                r = b - (b / n) * n;  // systematic
+                sampler->next ([col] (size_t i, size_t j) { col[i] = j + 1; });
             }
-            m = c[r];
-            c[r] = 0;
-        }
-        for ( size_t i = 0; i < n ; i++ ) {
-            if ( loo == true ) {
-                // Only leave-one-out if sample index r doesn't account for all
-                // remaining sampling counts
-                if (N == m) {
-                    c[r] = m;
-                    m = 0;
-                    loo = false;
-                }
+        } catch (const exception &e) {
+            err = e.what ();
+        }
+        if ( !err.empty () ) {
+            if ( tofile ) fclose (fid);
+            mexErrMsgTxt (err.c_str ());
+        }
+        if ( tofile ) {
+            if ( profiling ) t1 = chrono::steady_clock::now ();
+            if ( !write_bootmat_column (fid, col, n, type) ) {
+                fclose (fid);
+                mexErrMsgTxt ("Could not write to FILENAME.");
             }
-            distk.param (uniform_int_distribution<size_t>::param_type (0, N - m - 1));
-            k = distk (rng); 
-            d = c[0];
-            for ( size_t j = 0; j < n ; j++ ) { 
-                if ( k < d ) {
-                    if (isvec) {
-                        ptr[b * n + i] = x[j];
-                    } else {
-                        ptr[b * n + i] = j + 1;
-                    }
-                    if ( nboot > 1 ) {
-                      c[j] -= 1;
-                      N -= 1;
-                    }
-                    break;
-                } else {
-                    d += c[j + 1];
+            if ( profiling ) {
+                prof.write += seconds_since (t1);
+                if ( type != BOOTMAT_DOUBLE ) {
+                    prof.bytes_allocated += n * width;
                 }
+                prof.bytes_written += n * width;
             }
         }
-        if ( loo == true ) {
-            c[r] = m;
-            m = 0;
+    }
+    if ( tofile ) {
+        if ( profiling ) t1 = chrono::steady_clock::now ();
+        if ( fclose (fid) != 0 ) {
+            mexErrMsgTxt ("Could not write to FILENAME.");
+        }
+        if ( profiling ) prof.write += seconds_since (t1);
+    }
+
+    // Return and/or accumulate the instrumentation
+    if ( profiling ) {
+        prof.calls = 1;
+        prof.total = seconds_since (t0);
+        if ( nlhs > 1 ) {
+            plhs[1] = profile_struct (prof);
+        }
+        if ( profile_env () ) {
+            totals.calls += prof.calls;
+            totals.validation += prof.validation;
+            totals.allocation += prof.allocation;
+            totals.write += prof.write;
+            totals.total += prof.total;
+            totals.bytes_allocated += prof.bytes_allocated;
+            totals.bytes_written += prof.bytes_written;
+            totals.sampler.rng += prof.sampler.rng;
+            totals.sampler.search += prof.sampler.search;
+            totals.sampler.draws += prof.sampler.draws;
+            totals.sampler.steps += prof.sampler.steps;
         }
     }
 
@@ -0,0 +1,389 @@
+// boot.h
+// Header-only c++ library for balanced bootstrap and bootknife resampling. It
+// contains the resampling engine of the boot MEX file (boot.cpp) and functions
+// for writing BOOTSAM in the binary file format that is read by bootread.m,
+// neither of which depend on the MEX API. Include it as follows:
+//
+// #include "boot.h"
+//
+// USAGE
+// resampling::BalancedSampler sampler (N, NBOOT, LOO, SEED);
+// resampling::BalancedSampler sampler (N, NBOOT, LOO, SEED, COUNTS);
+// sampler.next (IDX);
+// sampler.next (PUT);
+// sampler.set_profile (PROF);
+// resampling::gather (Y, X, IDX, N);
+//
+// INPUT VARIABLES
+// N (size_t) is the number of rows (of the data vector)
+// NBOOT (size_t) is the number of bootstrap resamples
+// LOO (bool) to set the resampling method: false (for bootstrap) or true
+//   (for bootknife)
+// SEED (unsigned int) is used to initialise the pseudo-random number generator
+// COUNTS (vector<long long int>) is the number of times that each of the N
+//   sample indices is represented in the NBOOT resamples (i.e. WEIGHTS)
+//
+// Each call to next draws the next of the NBOOT resamples. next (IDX) writes
+// the N zero-based sample indices of the resample to the array IDX. next (PUT)
+// instead calls PUT (I, J) for each row I of the resample with the zero-based
+// sample index J, so that, for example, resampled data values can be written
+// directly to their destination. gather (Y, X, IDX, N) writes the resampled
+// values X[IDX[I]] of a data vector X for the N indices in IDX to Y. The
+// resamples (and the sequence of random numbers used to draw them, which is
+// that of std::mt19937_64) are identical to those returned by the boot MEX
+// file for the same input arguments. The constructor throws
+// std::invalid_argument if the input arguments are not valid, and next throws
+// std::out_of_range if all NBOOT resamples have already been drawn. See
+// boot.cpp for a description of the resampling methods.
+//
+// set_profile (PROF) enables instrumentation of subsequent calls to next, which
+// then add the number of random draws, the number of steps of the search for
+// the sampled indices and the time (in seconds) spent drawing random numbers
+// and searching to the BootProfile structure pointed to by PROF. The timings
+// include the overhead of reading the clock (3 times per draw), so they are
+// best used to compare the phases of a call. set_profile (NULL) disables the
+// instrumentation, which is the default and adds no overhead to next.
+//
+// The BOOTMAT functions write the header and columns of the binary file format
+// for BOOTSAM (see bootwrite.m): the magic string 'BOOTMAT1', followed by the
+// data type code (uint32), a reserved field (uint32), and the number of rows
+// and columns (uint64), and then the values in column-major order.
+//
+// Requirements: Compilation requires C++11
+//
+// Author: Andrew Charles Penn (2022)
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include "dispatch.h"
+
+// Number of counts skipped at a time by balanced_search
+#define BOOT_SEARCH_BLOCK 32
+
+// State size and middle word of the Mersenne Twister (MT19937-64)
+#define BOOT_MT_N 312
+#define BOOT_MT_M 156
+
+
+namespace resampling {
+
+
+// Counters and timings (in seconds) recorded by BalancedSampler::next when
+// instrumentation is enabled (see set_profile)
+struct BootProfile {
+    double rng;                  // Time drawing random numbers
+    double search;               // Time searching for (and putting) indices
+    unsigned long long draws;    // Number of random draws
+    unsigned long long steps;    // Number of steps of the linear search
+    BootProfile () : rng (0), search (0), draws (0), steps (0) {}
+};
+
+
+// Function to find the sample index j that the random draw k corresponds to,
+// i.e. the first j for which k < c[0] + ... + c[j], or n if there is none. The
+// counts are skipped in blocks of BOOT_SEARCH_BLOCK, the sums of which the
+// compiler can vectorize, before the index is found within the block. The
+// result is the same as that of a linear search through the counts.
+RESAMPLING_TARGET_CLONES
+inline size_t balanced_search (const long long int *c, size_t n,
+                               long long int k)
+{
+    long long int d = 0;
+    size_t j = 0;
+    for ( ; j + BOOT_SEARCH_BLOCK <= n ; j += BOOT_SEARCH_BLOCK ) {
+        long long int s = 0;
+        for ( size_t v = 0; v < BOOT_SEARCH_BLOCK ; v++ ) {
+            s += c[j + v];
+        }
+        if ( k < d + s ) break;
+        d += s;
+    }
+    for ( ; j < n ; j++ ) {
+        d += c[j];
+        if ( k < d ) return j;
+    }
+    return n;
+}
+
+
+// Function to generate the next BOOT_MT_N random numbers of the Mersenne
+// Twister (MT19937-64) with the state x, which is updated, and write them to y.
+// The state is updated in two loops (before and after the middle word) and the
+// numbers are then tempered in a third, all of which the compiler can
+// vectorize.
+RESAMPLING_TARGET_CLONES
+inline void mt19937_64_block (uint64_t *x, uint64_t *y)
+{
+    const uint64_t UPPER = 0xFFFFFFFF80000000ULL;
+    const uint64_t LOWER = 0x000000007FFFFFFFULL;
+    const uint64_t MATRIX = 0xB5026F5AA96619E9ULL;
+    size_t i = 0;
+    for ( ; i < BOOT_MT_N - BOOT_MT_M ; i++ ) {
+        const uint64_t z = (x[i] & UPPER) | (x[i + 1] & LOWER);
+        x[i] = x[i + BOOT_MT_M] ^ (z >> 1) ^ ((z & 1) ? MATRIX : 0);
+    }
+    for ( ; i < BOOT_MT_N - 1 ; i++ ) {
+        const uint64_t z = (x[i] & UPPER) | (x[i + 1] & LOWER);
+        x[i] = x[i + BOOT_MT_M - BOOT_MT_N] ^ (z >> 1) ^ ((z & 1) ? MATRIX : 0);
+    }
+    const uint64_t z = (x[BOOT_MT_N - 1] & UPPER) | (x[0] & LOWER);
+    x[BOOT_MT_N - 1] = x[BOOT_MT_M - 1] ^ (z >> 1) ^ ((z & 1) ? MATRIX : 0);
+    for ( i = 0; i < BOOT_MT_N ; i++ ) {
+        uint64_t v = x[i];
+        v ^= (v >> 29) & 0x5555555555555555ULL;
+        v ^= (v << 17) & 0x71D67FFFEDA60000ULL;
+        v ^= (v << 37) & 0xFFF7EEE000000000ULL;
+        v ^= (v >> 43);
+        y[i] = v;
+    }
+}
+
+
+// Mersenne Twister (MT19937-64) that returns the same sequence of random
+// numbers as std::mt19937_64 for the same seed, but generates them in blocks
+// (see mt19937_64_block), from which they are then returned one at a time.
+class MersenneTwister {
+
+    public:
+
+        typedef uint64_t result_type;
+
+        static constexpr result_type min () { return 0; }
+
+        static constexpr result_type max () { return UINT64_MAX; }
+
+        explicit MersenneTwister (uint64_t seed) : p (BOOT_MT_N) {
+            x[0] = seed;
+            for ( size_t i = 1; i < BOOT_MT_N ; i++ ) {
+                x[i] = 6364136223846793005ULL * (x[i - 1] ^ (x[i - 1] >> 62)) + i;
+            }
+        }
+
+        result_type operator() () {
+            if ( p == BOOT_MT_N ) {
+                mt19937_64_block (x, y);
+                p = 0;
+            }
+            return y[p++];
+        }
+
+    private:
+
+        uint64_t x[BOOT_MT_N];                 // State
+        uint64_t y[BOOT_MT_N];                 // Block of random numbers
+        size_t p;                              // Position in the block
+
+};
+
+
+class BalancedSampler {
+
+    public:
+
+        BalancedSampler (size_t n, size_t nboot, bool loo, unsigned int seed,
+                         const std::vector<long long int> &counts =
+                         std::vector<long long int> ())
+            : n (n), nboot (nboot), loo (loo), b (0), N (n * nboot),
+              c (n, nboot), m (0), r (-1), rng (seed),
+              distr (0, n > 0 ? n - 1 : 0), distk (0, N > 0 ? N - 1 : 0),
+              prof (NULL)
+        {
+            if ( n == 0 ) {
+                throw std::invalid_argument ("N must be a positive integer.");
+            }
+            if ( nboot == 0 ) {
+                throw std::invalid_argument ("NBOOT must be a positive integer.");
+            }
+            if ( !counts.empty () ) {
+                // Assign user defined weights (counts)
+                if ( counts.size () != n ) {
+                    throw std::invalid_argument ("WEIGHTS must be a vector of length N.");
+                }
+                long long int s = 0;
+                for ( size_t i = 0; i < n ; i++ ) {
+                    if ( counts[i] < 0 ) {
+                        throw std::invalid_argument ("WEIGHTS must contain only positive integers.");
+                    }
+                    c[i] = counts[i];
+                    s += c[i];
+                }
+                if ( s != (long long int) N ) {
+                    throw std::invalid_argument ("The elements of WEIGHTS must sum to N * NBOOT.");
+                }
+            }
+        }
+
+        size_t rows () const { return n; }
+
+        size_t cols () const { return nboot; }
+
+        // Number of resamples drawn so far
+        size_t drawn () const { return b; }
+
+        // Enable (or, if PROF is NULL, disable) instrumentation
+        void set_profile (BootProfile *p) { prof = p; }
+
+        template <typename Put>
+        void next (Put put) {
+            if ( prof == NULL ) {
+                draw<false> (put);
+            } else {
+                draw<true> (put);
+            }
+        }
+
+        void next (size_t *idx) {
+            next ([idx] (size_t i, size_t j) { idx[i] = j; });
+        }
+
+    private:
+
+        typedef std::chrono::steady_clock Clock;
+
+        static double seconds (Clock::time_point t0, Clock::time_point t1) {
+            return std::chrono::duration<double> (t1 - t0).count ();
+        }
+
+        // Draw the next resample, recording counters and timings in prof if
+        // PROFILE is true
+        template <bool PROFILE, typename Put>
+        void draw (Put put) {
+            if ( b >= nboot ) {
+                throw std::out_of_range ("All NBOOT resamples have already been drawn.");
+            }
+            if ( loo == true ) {
+                // Note that the following division operations are for integers
+                if ( (b / n) == (nboot / n) ) {
+                    r = distr (rng);      // random
+                    if ( PROFILE ) prof->draws++;
+                } else {
+                    r = b - (b / n) * n;  // systematic
+                }
+                m = c[r];
+                c[r] = 0;
+            }
+            for ( size_t i = 0; i < n ; i++ ) {
+                if ( loo == true ) {
+                    // Only leave-one-out if sample index r doesn't account for
+                    // all remaining sampling counts
+                    if ( N == (size_t) m ) {
+                        c[r] = m;
+                        m = 0;
+                        loo = false;
+                    }
+                }
+                Clock::time_point t0, t1;
+                if ( PROFILE ) t0 = Clock::now ();
+                distk.param (std::uniform_int_distribution<size_t>::param_type (0, N - m - 1));
+                size_t k = distk (rng);
+                if ( PROFILE ) t1 = Clock::now ();
+                size_t j = balanced_search (c.data (), n, k);
+                if ( j < n ) {
+                    put (i, j);
+                    if ( nboot > 1 ) {
+                      c[j] -= 1;
+                      N -= 1;
+                    }
+                }
+                if ( PROFILE ) {
+                    prof->rng += seconds (t0, t1);
+                    prof->search += seconds (t1, Clock::now ());
+                    prof->draws++;
+                    prof->steps += j + 1;
+                }
+            }
+            if ( loo == true ) {
+                c[r] = m;
+                m = 0;
+            }
+            b++;
+        }
+
+        size_t n;                              // Number of sample indices
+        size_t nboot;                          // Number of resamples
+        bool loo;                              // Leave-one-out (bootknife)
+        size_t b;                              // Number of resamples drawn
+        size_t N;                              // Total counts of all indices
+        std::vector<long long int> c;          // Counter for each index
+        long long int m;                       // Counter for LOO index r
+        long long int r;                       // Sample index for LOO
+        MersenneTwister rng;                   // Mersenne Twister 19937
+        std::uniform_int_distribution<size_t> distr;
+        std::uniform_int_distribution<size_t> distk;
+        BootProfile *prof;                     // Instrumentation (or NULL)
+
+};
+
+
+// Function to write the values of x at the n zero-based sample indices in idx
+// to y, i.e. to gather the resampled values of a data vector
+RESAMPLING_TARGET_CLONES
+inline void gather (double *y, const double *x, const size_t *idx, size_t n)
+{
+    for ( size_t i = 0; i < n ; i++ ) {
+        y[i] = x[idx[i]];
+    }
+}
+
+
+// Data type codes of the binary file format for BOOTSAM
+enum { BOOTMAT_DOUBLE = 0, BOOTMAT_UINT8 = 1, BOOTMAT_UINT16 = 2,
+       BOOTMAT_UINT32 = 3 };
+
+// Smallest data type that can hold sample indices in the range 1:N
+inline uint32_t bootmat_index_type (size_t n)
+{
+    if ( n <= UINT8_MAX ) {
+        return BOOTMAT_UINT8;
+    } else if ( n <= UINT16_MAX ) {
+        return BOOTMAT_UINT16;
+    } else {
+        return BOOTMAT_UINT32;
+    }
+}
+
+inline bool write_bootmat_header (FILE *fid, uint32_t type, uint64_t rows,
+                                  uint64_t cols)
+{
+    static const char MAGIC[8] = {'B', 'O', 'O', 'T', 'M', 'A', 'T', '1'};
+    const uint32_t reserved = 0;
+    return ( fwrite (MAGIC, 1, 8, fid) == 8 &&
+             fwrite (&type, sizeof (uint32_t), 1, fid) == 1 &&
+             fwrite (&reserved, sizeof (uint32_t), 1, fid) == 1 &&
+             fwrite (&rows, sizeof (uint64_t), 1, fid) == 1 &&
+             fwrite (&cols, sizeof (uint64_t), 1, fid) == 1 );
+}
+
+template <typename T>
+inline bool write_bootmat_cast (FILE *fid, const double *col, size_t n)
+{
+    std::vector<T> buf (col, col + n);
+    return ( fwrite (buf.data (), sizeof (T), n, fid) == n );
+}
+
+inline bool write_bootmat_column (FILE *fid, const double *col, size_t n,
+                                  uint32_t type)
+{
+    switch ( type ) {
+        case BOOTMAT_UINT8:
+            return write_bootmat_cast<uint8_t> (fid, col, n);
+        case BOOTMAT_UINT16:
+            return write_bootmat_cast<uint16_t> (fid, col, n);
+        case BOOTMAT_UINT32:
+            return write_bootmat_cast<uint32_t> (fid, col, n);
+        default:
+            return ( fwrite (col, sizeof (double), n, fid) == n );
+    }
+}
+
+
+} // namespace resampling
+
+#endif
@@ -0,0 +1,35 @@
+// dispatch.h
+// Runtime dispatch of the hot loops of the header-only c++ libraries boot.h
+// and smoothmedian.h, which both include it. Where the compiler and the
+// platform support function multiversioning (GCC >= 6 on x86-64 ELF systems),
+// functions marked with RESAMPLING_TARGET_CLONES are compiled for AVX-512, AVX2
+// and the baseline instruction set (SSE2), and the version for the processor is
+// selected when the MEX file is loaded, so that the binaries do not need to be
+// compiled with -march (see Makefile).
+//
+// Contraction of floating-point operations (into fused multiply-adds, which
+// are part of AVX-512) is disabled in the clones so that they all return
+// identical results. The clones are called through an indirect function and
+// cannot be inlined, so only mark functions that do enough work per call.
+// Define RESAMPLING_NO_DISPATCH to disable the dispatch.
+//
+// Requirements: Compilation requires C++11
+//
+// Author: Andrew Charles Penn (2022)
+
+#ifndef RESAMPLING_DISPATCH_H
+#define RESAMPLING_DISPATCH_H
+
+#ifndef RESAMPLING_TARGET_CLONES
+#if defined (__GNUC__) && !defined (__clang__) && (__GNUC__ >= 6) && \
+    defined (__x86_64__) && defined (__ELF__) && \
+    !defined (RESAMPLING_NO_DISPATCH)
+#define RESAMPLING_TARGET_CLONES \
+    __attribute__ ((target_clones ("avx512f", "avx2", "default"), \
+                    optimize ("fp-contract=off")))
+#else
+#define RESAMPLING_TARGET_CLONES
+#endif
+#endif
+
+#endif
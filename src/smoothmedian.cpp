@@ -9,14 +9,19 @@
 // M = smoothmedian (X)
 // M = smoothmedian (X, DIM)
 // M = smoothmedian (X, DIM, TOL)
+// M = smoothmedian (X, DIM, TOL, NCPUS)
+// [M, INFO] = smoothmedian (...)
+// INFO = smoothmedian ('profile')
 //
 // INPUT VARIABLES
 // X (double) is the data vector or matrix.
 // DIM (double) is the dimension (1 for columnwise, 2 for rowwise).
 // TOL (double) sets the step size that will stop optimization.
+// NCPUS (double) sets the number of threads used to process the columns/rows.
 //
 // OUTPUT VARIABLE
 // M (double) is a scalar or vector of the smoothed median(s)
+// INFO (struct) contains instrumentation counters and timings (see below)
 //
 // If X is a vector, find the univariate smoothed median (M) of X. If X is a
 // matrix, compute the univariate smoothed median value for each column and
@@ -25,6 +30,29 @@
 // currently supported. TOL configures the stopping criteria, in terms of the
 // absolute change in the step size. By default, TOL = RANGE * 1e-4.
 //
+// The columns (or rows) of X are processed in parallel by a pool of threads
+// that persists between calls. NCPUS sets the number of threads. If NCPUS is
+// not provided, it is taken from the environment variable
+// STATISTICS_RESAMPLING_NCPUS, or else the number of cores on the machine is
+// used. Small inputs are always processed in a single thread. The results do
+// not depend on the number of threads.
+//
+// If a second output (INFO) is requested, the call is instrumented and INFO is
+// a structure with the following fields: calls (the number of calls profiled),
+// the time (in seconds) spent on validation of the input arguments, allocation
+// of the output, copying each column/row of the data (copy), finding the
+// ordinary medians (median), in the Newton-Bisection iterations (newton) and
+// in total, the number of columns/rows, iterations, Newton and Bisection steps,
+// pairwise terms evaluated (pairs) and failures to reach tolerance, the number
+// of threads, the utilization of the threads (the proportion of the time that
+// they spent processing columns/rows), and the number of bytes allocated. The
+// copy, median and newton timings are summed over the threads. If
+// the environment variable STATISTICS_RESAMPLING_PROFILE is set (to a value
+// other than 0), every call is instrumented and the counters and timings are
+// added to running totals, which are returned (and then reset) by
+// INFO = smoothmedian ('profile'). This can be used to attribute the time
+// spent in smoothmedian by functions that call it, such as bootknife.
+//
 // The smoothed median is a slightly smoothed version of the ordinary 
 // median and is an M-estimator that is both robust and efficient:
 //
@@ -62,27 +90,118 @@
 // [1] Brown, Hall and Young (2001) The smoothed median and the
 //      bootstrap. Biometrika 88(2):519-534
 //
-// Requirements: Compilation requires C++98
+// The solver and the pool of threads are implemented in smoothmedian.h, which
+// can be used without the MEX API.
+//
+// Requirements: Compilation requires C++11
 //
 // Author: Andrew Charles Penn (2022)
 
 
-#include "mex.h"         // for mex functions
-#include <vector>        // for vector function
-#include <cmath>         // for pow function
-#include <limits>        // for numeric limits functions
-#include <algorithm>     // for nth_element function
+#include "mex.h"            // for mex functions
+#include "smoothmedian.h"   // for the solver and the pool of threads
+#include <vector>           // for vector function
+#include <cstdlib>          // for getenv and atoi functions
+#include <cstring>          // for strcmp function
+#include <thread>           // for hardware_concurrency
+#include <chrono>           // for steady_clock
+#include <algorithm>        // for max function
+#include <string>           // for string class
+#include <exception>        // for exception class
 using namespace std;
+using namespace resampling;
+
+
+// Instrumentation counters and timings of one or more calls
+struct Profile {
+    double calls, validation, allocation, total, columns, failures, threads,
+           bytes_allocated;
+    SmoothmedProfile solver;
+    Profile () : calls (0), validation (0), allocation (0), total (0),
+                 columns (0), failures (0), threads (0), bytes_allocated (0) {}
+};
+
+// Running totals of the calls profiled since they were last returned
+static Profile totals;
+
+static bool profile_env (void) {
+    const char *env = getenv ("STATISTICS_RESAMPLING_PROFILE");
+    return ( env != 0 && env[0] != '\0' && strcmp (env, "0") != 0 );
+}
+
+static double seconds_since (chrono::steady_clock::time_point t0) {
+    return chrono::duration<double> (chrono::steady_clock::now () - t0).count ();
+}
+
+static mxArray *profile_struct (const Profile &p) {
+    const char *fields[] = {"calls", "validation", "allocation", "copy",
+                            "median", "newton", "total", "columns",
+                            "iterations", "newton_steps", "bisection_steps",
+                            "pairs", "failures", "threads", "utilization",
+                            "bytes_allocated"};
+    const double vals[] = {p.calls, p.validation, p.allocation, p.solver.copy,
+                           p.solver.median, p.solver.newton, p.total,
+                           p.columns, (double) p.solver.iterations,
+                           (double) p.solver.newton_steps,
+                           (double) p.solver.bisection_steps,
+                           (double) p.solver.pairs, p.failures, p.threads,
+                           ( p.solver.capacity > 0 ) ?
+                             p.solver.busy / p.solver.capacity : 0,
+                           p.bytes_allocated};
+    const int nfields = sizeof (fields) / sizeof (fields[0]);
+    mxArray *s = mxCreateStructMatrix (1, 1, nfields, fields);
+    for ( int i = 0; i < nfields; i++ ) {
+        mxSetField (s, 0, fields[i], mxCreateDoubleScalar (vals[i]));
+    }
+    return s;
+}
+
+
+// Persistent pool of worker threads (see smoothmedian.h), which is shut down
+// when the MEX file is cleared
+static ThreadPool pool;
+
+static void shutdown_pool (void) {
+    pool.resize (1);
+}
 
 
 void mexFunction (int nlhs, mxArray* plhs[],
                   int nrhs, const mxArray* prhs[]) 
 {
 
+    // Return (and reset) the running totals of the instrumentation
+    if ( nrhs == 1 && mxIsChar (prhs[0]) ) {
+        char *str = mxArrayToString (prhs[0]);
+        bool isprofile = ( strcmp (str, "profile") == 0 );
+        mxFree (str);
+        if ( !isprofile ) {
+            mexErrMsgTxt ("The only valid string input argument is 'profile'.");
+        }
+        if ( nlhs > 1 ) {
+            mexErrMsgTxt ("Too many output arguments.");
+        }
+        plhs[0] = profile_struct (totals);
+        totals = Profile ();
+        return;
+    }
+
+    // Start the clock if the call is to be instrumented
+    const bool profiling = ( nlhs > 1 || profile_env () );
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now ();
+    chrono::steady_clock::time_point t1;
+    Profile prof;
+
     // Input variables
     if ( nrhs < 1 ) {
         mexErrMsgTxt ("At least one input argument is required.");
     }
+    if ( nrhs > 4 ) {
+        mexErrMsgTxt ("Too many input arguments.");
+    }
+    if ( nlhs > 2 ) {
+        mexErrMsgTxt ("Too many output arguments.");
+    }
     // First input argument (x)
     if ( !mxIsClass (prhs[0], "double") ) {
         mexErrMsgTxt ("The first input argument (X) must be of type double");
@@ -111,8 +230,9 @@ void mexFunction (int nlhs, mxArray* plhs[],
         mexErrMsgTxt ("The second input argument (DIM) must be 1 (column-wise) or 2 (row-wise)");
     }
     // Third input argument (Tol)
-    double Tol;
-    if ( nrhs > 2 && !mxIsEmpty (prhs[2]) ) {
+    double Tol = 0;
+    bool hasTol = ( nrhs > 2 && !mxIsEmpty (prhs[2]) );
+    if ( hasTol ) {
         if ( mxGetNumberOfElements (prhs[2]) > 1 ) {
             mexErrMsgTxt ("The third input argument (TOL) must be scalar");
         }
@@ -130,6 +250,38 @@ void mexFunction (int nlhs, mxArray* plhs[],
             mexErrMsgTxt ("The third input argument (TOL) must be a positive value");
         }
     }
+    // Fourth input argument (ncpus)
+    int ncpus;
+    if ( nrhs > 3 && !mxIsEmpty (prhs[3]) ) {
+        if ( mxGetNumberOfElements (prhs[3]) > 1 ) {
+            mexErrMsgTxt ("The fourth input argument (NCPUS) must be scalar");
+        }
+        if ( !mxIsClass (prhs[3], "double") ) {
+            mexErrMsgTxt ("The fourth input argument (NCPUS) must be of type double");
+        }
+        if ( mxIsComplex (prhs[3]) ) {
+            mexErrMsgTxt ("The fourth input argument (NCPUS) cannot contain an imaginary part");
+        }
+        double val = *(mxGetPr (prhs[3]));
+        if ( !mxIsFinite (val) || val < 1 || val != int (val) ) {
+            mexErrMsgTxt ("The fourth input argument (NCPUS) must be a positive integer");
+        }
+        ncpus = static_cast<int> (val);
+    } else {
+        const char *env = getenv ("STATISTICS_RESAMPLING_NCPUS");
+        ncpus = ( env != 0 ) ? atoi (env) : 0;
+        if ( ncpus < 1 ) {
+            ncpus = thread::hardware_concurrency ();
+        }
+        if ( ncpus < 1 ) {
+            ncpus = 1;
+        }
+    }
+
+    if ( profiling ) {
+        prof.validation = seconds_since (t0);
+        t1 = chrono::steady_clock::now ();
+    }
 
     // Get data dimensions and prepare output vector
     int ndims = (int) mxGetNumberOfDimensions (prhs[0]);
@@ -137,7 +289,7 @@ void mexFunction (int nlhs, mxArray* plhs[],
     if ( sz[0] == 1 ) {
         dim = 2;
     }
-    int m, n, l;
+    int m, n;
     if ( dim == 1 ) {
         m = sz[0];
         n = sz[1];
@@ -150,125 +302,71 @@ void mexFunction (int nlhs, mxArray* plhs[],
     int N = mxGetNumberOfElements (prhs[0]);
     double *M = (double *) mxGetData(plhs[0]);
 
-    // Declare temporary variables needed for the optimization step
-    vector<double> xvec;
-    xvec.reserve (m);
-    double a, b, mid, range, S, T, U, D, R, step, nwt;
-
-    // Loop through the data and apply smoothing to the median (maximum 25 iterations)
-    int MaxIter = 24;
-    for ( int k = 0; k < n ; k++ ) {
-
-        // Copy the next row/column of the data to temporary vector
-        if ( dim == 1 ) {
-            for ( int j = 0; j < m ; j++ ) xvec.push_back ( x[k * m + j] );
-        } else if ( dim == 2 ) { 
-            for ( int j = 0; j < m ; j++ ) {int i = j * n; xvec.push_back ( x[i + k] );};
-        }
-
-        // Omit NaN values and calculate the length of the resulting vector
-        xvec.erase (remove_if (xvec.begin(), xvec.end(), mxIsNaN), xvec.end());
-        l = xvec.size ();
-        if (l == 0) {
-            M[k] = numeric_limits<double>::quiet_NaN();
-            continue;
-        }
-
-        // Set the (ordinary) median as the starting value
-        mid = 0.5 * l;
-        nth_element (xvec.begin(), xvec.begin() + int (mid), xvec.end());
-        // After running nth_element, none of the elements in xvec preceding the
-        // nth are greater than it, and none of the elements after it are less.
-        if ( mid == int (mid) ) {
-            // Median when l is even
-            M[k] = xvec[mid];
-            M[k] += *max_element (xvec.begin(), xvec.begin() + mid);
-            M[k] *= 0.5;
-        } else {
-            // Median when l is odd
-            mid = int (mid);
-            M[k] = xvec[mid];
-        }
-
-        // Set initial bracket bounds to the minimum and maximum data values
-        a = *min_element (xvec.begin(), xvec.begin() + mid);
-        b = *max_element (xvec.begin() + mid, xvec.end());
-
-        // Calculate range
-        range = b - a;
-        
-        // Set stopping criteria (if Tol is not already specified)
-        if ( nrhs < 3 || mxIsEmpty (prhs[2]) ) {
-            Tol = range * 1e-4; 
+    // Compute the smoothed median of each row/column of the data, only using
+    // multiple threads when there is enough work to share
+    int nthreads = smoothmedian_threads (m, n, ncpus);
+    vector<char> failed (n, 0);
+    SmoothmedProfile *p = profiling ? &prof.solver : NULL;
+    if ( profiling ) {
+        prof.allocation = seconds_since (t1);
+        // Output, failure flags and a copy of each column/row of the data
+        prof.bytes_allocated = n * (sizeof (double) + sizeof (char)) +
+                               (double) n * m * sizeof (double);
+    }
+    // Exceptions (e.g. from memory allocation) must not escape the MEX
+    // function, so any error is caught and raised by mexErrMsgTxt once the
+    // handler has exited
+    string err;
+    if ( nthreads > 1 ) {
+        if ( pool.size () != (unsigned int) ncpus ) {
+            pool.resize (ncpus);
+            mexAtExit (shutdown_pool);
         }
+    }
+    try {
+        smoothmedian (x, m, n, dim, Tol, hasTol, M, failed.data (),
+                      nthreads > 1 ? &pool : NULL, p);
+    } catch (const exception &e) {
+        err = e.what ();
+    } catch (...) {
+        err = "Unknown error.";
+    }
+    if ( !err.empty () ) {
+        mexErrMsgTxt (err.c_str ());
+    }
 
-        // Start iterations
-        for ( int Iter = 0; Iter <= MaxIter ; Iter++ ) {
-
-            // Break from iterations if the distance between the bracket bounds 
-            // < Tol since the smoothed median will be equal to the median 
-            if ( range <= Tol ) {
-                break;
-            }
-
-            // Calculate derivatives of the objective function for Newton-Raphson method
-            //S = 0;
-            T = 0;
-            U = 0;
-            for ( int j = 0; j < l ; j++ ) {
-                for ( int i = 0; i < j ; i++ ) {
-                    D = pow (xvec[i] - M[k], 2) + pow (xvec [j] - M[k], 2);
-                    R = sqrt (D);
-                    // Objective function (S)
-                    //S += R;
-                    if ( D != 0 ) {
-                        // First derivative (T)
-                        T += (2 * M[k] - xvec[i] - xvec [j]) / R;
-                        // Second derivative (U)
-                        U += pow (xvec[i] - xvec [j], 2) * R / pow (D, 2);
-                    }
-                }
-            }
-
-            // Compute Newton step (fast quadratic convergence but unreliable)
-            step = T / U;
-
-            // Evaluate convergence
-            if ( abs (step) <= Tol ) {
-                break; // Break from optimization when converged to tolerance 
+    // Print warnings (from the main thread)
+    for ( int k = 0; k < n ; k++ ) {
+        if ( failed[k] ) {
+            if (dim == 1) {
+                mexPrintf ("warning: Root finding failed to reach tolerance for column %d \n", k+1);
             } else {
-                // Update bracket bounds for Bisection method
-                if ( step < 0 ) {
-                    a = M[k] + Tol;
-                } else if ( step > 0 ) {
-                    b = M[k] - Tol;
-                }
-                // Update the range with the distance between the bracket bounds
-                range = b - a;
-                // Preview new value of the smoothed median
-                nwt = M[k] - step;
-                // Choose which method to use to update the smoothed median
-                if ( nwt > a && nwt < b ) {
-                    // Use Newton step if it is within bracket bounds
-                    M[k] = nwt;
-                } else {
-                    // Compute Bisection step (slow linear convergence but very safe)
-                    M[k] = 0.5 * (a + b);
-                }
-            }
-
-            if ( Iter == MaxIter ) {
-                if (dim == 1) {
-                    mexPrintf ("warning: Root finding failed to reach tolerance for column %d \n", k+1);
-                } else {
-                    mexPrintf ("warning: Root finding failed to reach tolerance for row %d \n", k+1);
-                }
+                mexPrintf ("warning: Root finding failed to reach tolerance for row %d \n", k+1);
             }
-
+            prof.failures++;
         }
+    }
 
-        // Clear the temporary vector for the next cycle of the loop
-        xvec.clear();
+    // Return and/or accumulate the instrumentation
+    if ( profiling ) {
+        prof.calls = 1;
+        prof.columns = n;
+        prof.threads = ( nthreads > 1 ) ? pool.size () : 1;
+        prof.total = seconds_since (t0);
+        if ( nlhs > 1 ) {
+            plhs[1] = profile_struct (prof);
+        }
+        if ( profile_env () ) {
+            totals.calls += prof.calls;
+            totals.validation += prof.validation;
+            totals.allocation += prof.allocation;
+            totals.total += prof.total;
+            totals.columns += prof.columns;
+            totals.failures += prof.failures;
+            totals.threads = max (totals.threads, prof.threads);
+            totals.bytes_allocated += prof.bytes_allocated;
+            totals.solver.add (prof.solver);
+        }
     }
 
     return;
@@ -0,0 +1,456 @@
+// smoothmedian.h
+// Header-only c++ library for calculating the smoothed median [1]. It contains
+// the solver and the pool of worker threads used by the smoothmedian MEX file
+// (smoothmedian.cpp), neither of which depend on the MEX API. Include it as
+// follows:
+//
+// #include "smoothmedian.h"
+//
+// USAGE
+// resampling::smoothmed (XVEC, TOL, HASTOL, M, FAILED);
+// resampling::smoothmed (XVEC, TOL, HASTOL, M, FAILED, PROF);
+// resampling::smoothmedian (X, ROWS, COLS, DIM, TOL, HASTOL, M, FAILED);
+// resampling::smoothmedian (X, ROWS, COLS, DIM, TOL, HASTOL, M, FAILED, POOL);
+// resampling::smoothmedian (..., FAILED, POOL, PROF);
+//
+// INPUT VARIABLES
+// XVEC (vector<double>) is a data vector, which is modified
+// X (const double *) is a ROWS x COLS data matrix in column-major order
+// DIM (int) is the dimension (1 for columnwise, 2 for rowwise)
+// TOL (double) sets the step size that will stop optimization. TOL is ignored
+//   (and the default of RANGE * 1e-4 is used) unless HASTOL is true.
+// POOL (ThreadPool *) is a pool of threads used to process the columns/rows
+// PROF (SmoothmedProfile *) enables instrumentation if it is not NULL
+//
+// OUTPUT VARIABLES
+// M (double) is the smoothed median of XVEC, or (double *) the smoothed
+//   median of each column (DIM = 1) or row (DIM = 2) of X
+// FAILED (bool) is set true, or (char *) the element of FAILED for each column
+//   or row is set true, if root finding does not reach tolerance
+//
+// The functions do not print warnings; see smoothmedian.cpp for a description
+// of the smoothed median and the root finding algorithm. smoothmedian_threads
+// returns the number of threads worth using for a data matrix of a given size.
+// Any exception (e.g. std::bad_alloc) thrown while processing a column/row is
+// thrown by smoothmedian in the calling thread.
+//
+// If PROF is not NULL, the number of iterations, Newton and Bisection steps and
+// pairwise terms evaluated, and the time (in seconds) spent copying the data,
+// finding the ordinary median and iterating, are added to the SmoothmedProfile
+// structure pointed to by PROF. smoothmedian also adds the total time that the
+// threads spent processing columns/rows (BUSY), and the number of threads times
+// the time taken to process them all (CAPACITY), the ratio of which is the
+// utilization of the threads. Instrumentation does not change the results.
+//
+// Bibliography:
+// [1] Brown, Hall and Young (2001) The smoothed median and the
+//      bootstrap. Biometrika 88(2):519-534
+//
+// Requirements: Compilation requires C++11
+//
+// Author: Andrew Charles Penn (2022)
+
+#ifndef SMOOTHMEDIAN_H
+#define SMOOTHMEDIAN_H
+
+#include <vector>           // for vector function
+#include <cmath>            // for pow function
+#include <limits>           // for numeric limits functions
+#include <algorithm>        // for nth_element function
+#include <atomic>           // for atomic counters
+#include <condition_variable>
+#include <exception>        // for exception_ptr
+#include <functional>       // for function objects
+#include <mutex>
+#include <thread>           // for thread and hardware_concurrency
+#include <chrono>           // for steady_clock
+#include "dispatch.h"       // for RESAMPLING_TARGET_CLONES
+
+// Number of partial sums of the terms kept by smoothmed_derivs
+#define SMOOTHMED_LANES 8
+
+
+namespace resampling {
+
+
+// Counters and timings (in seconds) recorded by smoothmed and smoothmedian
+// when instrumentation is enabled
+struct SmoothmedProfile {
+    double copy;                 // Time copying the data to vectors
+    double median;               // Time finding the (ordinary) median
+    double newton;               // Time in Newton-Bisection iterations
+    double busy;                 // Total time threads spent on columns/rows
+    double capacity;             // Number of threads x time taken
+    unsigned long long iterations;
+    unsigned long long newton_steps;
+    unsigned long long bisection_steps;
+    unsigned long long pairs;    // Number of pairwise terms evaluated
+    SmoothmedProfile () : copy (0), median (0), newton (0), busy (0),
+                          capacity (0), iterations (0), newton_steps (0),
+                          bisection_steps (0), pairs (0) {}
+    void add (const SmoothmedProfile &p) {
+        copy += p.copy;
+        median += p.median;
+        newton += p.newton;
+        busy += p.busy;
+        capacity += p.capacity;
+        iterations += p.iterations;
+        newton_steps += p.newton_steps;
+        bisection_steps += p.bisection_steps;
+        pairs += p.pairs;
+    }
+};
+
+// Time (in seconds) between two readings of the steady clock
+inline double elapsed (std::chrono::steady_clock::time_point t0,
+                       std::chrono::steady_clock::time_point t1) {
+    return std::chrono::duration<double> (t1 - t0).count ();
+}
+
+
+// Persistent pool of worker threads. The threads are created on the first call
+// that needs them and are then reused by subsequent calls until the number of
+// threads requested changes or the pool is destroyed. Each call to run
+// executes task (k) for k = 0, ..., ntasks - 1, with the calling thread also
+// taking part, and returns once all of the tasks have been completed. If a
+// task throws an exception, the remaining tasks are skipped and the (first)
+// exception is rethrown by run in the calling thread, once none of the
+// threads are still executing tasks. The tasks must not call any functions of
+// the MEX API.
+class ThreadPool {
+
+    public:
+
+        ThreadPool () : stop (false), generation (0), busy (0), ntasks (0) {}
+
+        ~ThreadPool () { resize (0); }
+
+        unsigned int size () const { return workers.size () + 1; }
+
+        void resize (unsigned int nthreads) {
+            if ( nthreads == size () && !stop ) return;
+            // Stop and join any existing worker threads
+            {
+                std::lock_guard<std::mutex> lock (mtx);
+                stop = true;
+            }
+            start.notify_all ();
+            for ( size_t i = 0; i < workers.size (); i++ ) workers[i].join ();
+            workers.clear ();
+            stop = false;
+            // Create the new worker threads
+            for ( unsigned int i = 1; i < nthreads; i++ ) {
+                workers.push_back (std::thread (&ThreadPool::worker, this));
+            }
+        }
+
+        void run (int n, const std::function<void (int)> &f) {
+            if ( workers.empty () ) {
+                for ( int k = 0; k < n; k++ ) f (k);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock (mtx);
+                task = &f;
+                ntasks = n;
+                next = 0;
+                busy = workers.size ();
+                generation++;
+            }
+            start.notify_all ();
+            work ();
+            std::unique_lock<std::mutex> lock (mtx);
+            done.wait (lock, [this] { return busy == 0; });
+            task = 0;
+            std::exception_ptr e = error;
+            error = nullptr;
+            lock.unlock ();
+            if ( e ) std::rethrow_exception (e);
+        }
+
+    private:
+
+        void work () {
+            for ( int k = next++; k < ntasks; k = next++ ) {
+                try {
+                    (*task) (k);
+                } catch (...) {
+                    // Keep the first exception and skip the remaining tasks
+                    std::lock_guard<std::mutex> lock (mtx);
+                    if ( !error ) error = std::current_exception ();
+                    next = ntasks;
+                }
+            }
+        }
+
+        void worker () {
+            unsigned long seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock (mtx);
+                    start.wait (lock, [&] { return stop || generation != seen; });
+                    if ( stop ) return;
+                    seen = generation;
+                }
+                work ();
+                {
+                    std::lock_guard<std::mutex> lock (mtx);
+                    busy--;
+                }
+                done.notify_one ();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::mutex mtx;
+        std::condition_variable start, done;
+        bool stop;
+        unsigned long generation;
+        size_t busy;
+        const std::function<void (int)> *task;
+        int ntasks;
+        std::atomic<int> next;
+        std::exception_ptr error;
+
+};
+
+// Thread-safe test for NaN values (for use in place of mxIsNaN)
+inline bool is_nan (double val) {
+    return val != val;
+}
+
+
+// Function to calculate the first (T) and second (U) derivatives of the
+// objective function at M, summed over the pairs (i < j) of the l values in x.
+// For each j, the terms of the pairs are first evaluated (independently of
+// each other, with one square root and one division each) into dt and du, each
+// of which has room for l values. They are then added, in blocks of
+// SMOOTHMED_LANES, to as many partial sums, which are combined at the end.
+// Both are loops without branches that the compiler can vectorize (with
+// -fno-math-errno and -fno-trapping-math, see Makefile), and since the order
+// of the additions to each partial sum is fixed, all of the clones created by
+// RESAMPLING_TARGET_CLONES return identical results.
+RESAMPLING_TARGET_CLONES
+inline void smoothmed_derivs (const double *x, int l, double M, double &T,
+                              double &U, double *dt, double *du)
+{
+    double t[SMOOTHMED_LANES] = {0}, u[SMOOTHMED_LANES] = {0};
+    T = 0;
+    U = 0;
+    for ( int j = 1; j < l ; j++ ) {
+        const double xj = x[j];
+        const double dj = (xj - M) * (xj - M);
+        for ( int i = 0; i < j ; i++ ) {
+            const double xi = x[i];
+            const double D = (xi - M) * (xi - M) + dj;
+            // Terms are zero (rather than skipped) if D is zero
+            const bool skip = ( D == 0 );
+            const double S = skip ? 1 : D;
+            const double Q = 1 / std::sqrt (S);
+            // First derivative (T)
+            dt[i] = skip ? 0 : (2 * M - xi - xj) * Q;
+            // Second derivative (U)
+            du[i] = skip ? 0 : (xi - xj) * (xi - xj) * (Q * Q * Q);
+        }
+        int i = 0;
+        for ( ; i + SMOOTHMED_LANES <= j ; i += SMOOTHMED_LANES ) {
+            for ( int v = 0; v < SMOOTHMED_LANES ; v++ ) {
+                t[v] += dt[i + v];
+                u[v] += du[i + v];
+            }
+        }
+        for ( ; i < j ; i++ ) {
+            T += dt[i];
+            U += du[i];
+        }
+    }
+    for ( int v = 0; v < SMOOTHMED_LANES ; v++ ) {
+        T += t[v];
+        U += u[v];
+    }
+}
+
+
+// Function to calculate the smoothed median of the l values in xvec, which is
+// modified. M is the smoothed median and failed is set true if the root
+// finding does not reach tolerance. Tol is ignored unless hasTol is true. If
+// prof is not NULL, counters and timings are added to it.
+inline void smoothmed (std::vector<double> &xvec, double Tol, bool hasTol,
+                double &M, bool &failed, SmoothmedProfile *prof = NULL) 
+{
+
+    double a, b, mid, range, T, U, step, nwt;
+    int l;
+    int MaxIter = 24;
+    failed = false;
+    std::chrono::steady_clock::time_point t0;
+    if ( prof != NULL ) t0 = std::chrono::steady_clock::now ();
+
+    // Omit NaN values and calculate the length of the resulting vector
+    xvec.erase (std::remove_if (xvec.begin(), xvec.end(), is_nan), xvec.end());
+    l = xvec.size ();
+    if (l == 0) {
+        M = std::numeric_limits<double>::quiet_NaN();
+        return;
+    }
+
+    // Set the (ordinary) median as the starting value
+    mid = 0.5 * l;
+    std::nth_element (xvec.begin(), xvec.begin() + int (mid), xvec.end());
+    // After running nth_element, none of the elements in xvec preceding the
+    // nth are greater than it, and none of the elements after it are less.
+    if ( mid == int (mid) ) {
+        // Median when l is even
+        M = xvec[mid];
+        M += *std::max_element (xvec.begin(), xvec.begin() + mid);
+        M *= 0.5;
+    } else {
+        // Median when l is odd
+        mid = int (mid);
+        M = xvec[mid];
+    }
+
+    // Set initial bracket bounds to the minimum and maximum data values
+    a = *std::min_element (xvec.begin(), xvec.begin() + mid);
+    b = *std::max_element (xvec.begin() + mid, xvec.end());
+
+    // Calculate range
+    range = b - a;
+
+    // Set stopping criteria (if Tol is not already specified)
+    if ( !hasTol ) {
+        Tol = range * 1e-4; 
+    }
+
+    std::chrono::steady_clock::time_point t1;
+    if ( prof != NULL ) {
+        t1 = std::chrono::steady_clock::now ();
+        prof->median += elapsed (t0, t1);
+    }
+
+    // Workspace for the terms of the pairs (see smoothmed_derivs)
+    std::vector<double> work (2 * l);
+
+    // Start iterations (maximum 25 iterations)
+    for ( int Iter = 0; Iter <= MaxIter ; Iter++ ) {
+
+        // Break from iterations if the distance between the bracket bounds 
+        // < Tol since the smoothed median will be equal to the median 
+        if ( range <= Tol ) {
+            break;
+        }
+        if ( prof != NULL ) {
+            prof->iterations++;
+            prof->pairs += (unsigned long long) l * (l - 1) / 2;
+        }
+
+        // Calculate derivatives of the objective function for Newton-Raphson method
+        smoothmed_derivs (xvec.data (), l, M, T, U, &work[0], &work[l]);
+
+        // Compute Newton step (fast quadratic convergence but unreliable)
+        step = T / U;
+
+        // Evaluate convergence
+        if ( std::abs (step) <= Tol ) {
+            break; // Break from optimization when converged to tolerance 
+        } else {
+            // Update bracket bounds for Bisection method
+            if ( step < 0 ) {
+                a = M + Tol;
+            } else if ( step > 0 ) {
+                b = M - Tol;
+            }
+            // Update the range with the distance between the bracket bounds
+            range = b - a;
+            // Preview new value of the smoothed median
+            nwt = M - step;
+            // Choose which method to use to update the smoothed median
+            if ( nwt > a && nwt < b ) {
+                // Use Newton step if it is within bracket bounds
+                M = nwt;
+                if ( prof != NULL ) prof->newton_steps++;
+            } else {
+                // Compute Bisection step (slow linear convergence but very safe)
+                M = 0.5 * (a + b);
+                if ( prof != NULL ) prof->bisection_steps++;
+            }
+        }
+
+        if ( Iter == MaxIter ) {
+            failed = true;
+        }
+
+    }
+
+    if ( prof != NULL ) {
+        prof->newton += elapsed (t1, std::chrono::steady_clock::now ());
+    }
+
+    return;
+
+}
+
+
+
+// Number of threads worth using to compute the smoothed median of each of the
+// n columns/rows (of length m) of a data matrix with ncpus threads available
+inline int smoothmedian_threads (int m, int n, int ncpus)
+{
+    // Only use multiple threads when there is enough work to share
+    int nthreads = std::min (ncpus, n);
+    if ( (double) m * m * n < 1e+05 ) {
+        nthreads = 1;
+    }
+    return nthreads;
+}
+
+
+// Function to calculate the smoothed median of each column (dim = 1) or row
+// (dim = 2) of the m x n (dim = 1) or n x m (dim = 2) matrix x. The columns/rows
+// are processed by the threads of pool, if pool is not NULL. If prof is not
+// NULL, counters and timings are added to it.
+inline void smoothmedian (const double *x, int m, int n, int dim, double Tol,
+                          bool hasTol, double *M, char *failed,
+                          ThreadPool *pool = NULL,
+                          SmoothmedProfile *prof = NULL)
+{
+
+    // Each column/row is instrumented separately so that the threads do not
+    // share counters
+    std::vector<SmoothmedProfile> profs (prof != NULL ? n : 0);
+    std::function<void (int)> task = [&] (int k) {
+        SmoothmedProfile *p = ( prof != NULL ) ? &profs[k] : NULL;
+        std::chrono::steady_clock::time_point t0;
+        if ( p != NULL ) t0 = std::chrono::steady_clock::now ();
+        // Copy the row/column of the data to a temporary vector
+        std::vector<double> xvec;
+        xvec.reserve (m);
+        if ( dim == 1 ) {
+            for ( int j = 0; j < m ; j++ ) xvec.push_back ( x[k * m + j] );
+        } else if ( dim == 2 ) { 
+            for ( int j = 0; j < m ; j++ ) {int i = j * n; xvec.push_back ( x[i + k] );};
+        }
+        if ( p != NULL ) p->copy += elapsed (t0, std::chrono::steady_clock::now ());
+        bool fail;
+        smoothmed (xvec, Tol, hasTol, M[k], fail, p);
+        failed[k] = fail;
+        if ( p != NULL ) p->busy += elapsed (t0, std::chrono::steady_clock::now ());
+    };
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now ();
+    if ( pool != NULL ) {
+        pool->run (n, task);
+    } else {
+        for ( int k = 0; k < n ; k++ ) task (k);
+    }
+    if ( prof != NULL ) {
+        for ( int k = 0; k < n ; k++ ) prof->add (profs[k]);
+        unsigned int nthreads = ( pool != NULL ) ? pool->size () : 1;
+        prof->capacity += nthreads * elapsed (t0, std::chrono::steady_clock::now ());
+    }
+
+}
+
+
+} // namespace resampling
+
+#endif
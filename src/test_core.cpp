@@ -0,0 +1,431 @@
+// test_core.cpp
+// c++ source code for a native executable that tests and benchmarks the
+// resampling engine (boot.h) and the smoothed median solver (smoothmedian.h)
+// without Octave or Matlab. Build and run it from the src directory with:
+//
+// make test
+// make bench
+//
+// USAGE
+// ./test_core
+// ./test_core bench
+// ./test_core bench FILENAME
+//
+// The first runs the tests and returns a nonzero exit status if any of them
+// fail. The second prints the time taken (the best of 3 runs) and throughput of
+// each of the library functions for a grid of typical problem sizes, and for
+// smoothmedian, with 1, 2, 4, ... threads up to the number of cores. The third
+// also appends the results to the comma-separated values (CSV) file FILENAME.
+// See also inst/bootbench.m, which benchmarks the functions of the package.
+//
+// Requirements: Compilation requires C++11
+//
+// Author: Andrew Charles Penn (2022)
+
+#include "boot.h"
+#include "smoothmedian.h"
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+using namespace std;
+using namespace resampling;
+
+
+static int nfail = 0;
+
+#define CHECK(cond) \
+    if ( !(cond) ) { \
+        printf ("FAIL (line %d): %s\n", __LINE__, #cond); \
+        nfail++; \
+    }
+
+
+// Draws all of the resamples into an n x nboot matrix of zero-based indices
+static vector<size_t> draw (size_t n, size_t nboot, bool loo, unsigned int seed,
+                            const vector<long long int> &counts =
+                            vector<long long int> ())
+{
+    BalancedSampler sampler (n, nboot, loo, seed, counts);
+    vector<size_t> bootsam (n * nboot);
+    for ( size_t b = 0; b < nboot; b++ ) sampler.next (&bootsam[b * n]);
+    return bootsam;
+}
+
+
+static void test_boot ()
+{
+
+    // Resampling is balanced and reproducible
+    for ( int loo = 0; loo < 2; loo++ ) {
+        size_t n = 7, nboot = 20;
+        vector<size_t> bootsam = draw (n, nboot, loo, 1);
+        vector<size_t> count (n, 0);
+        for ( size_t k = 0; k < n * nboot; k++ ) count[bootsam[k]]++;
+        for ( size_t j = 0; j < n; j++ ) CHECK (count[j] == nboot);
+        CHECK (draw (n, nboot, loo, 1) == bootsam);
+        CHECK (draw (n, nboot, loo, 2) != bootsam);
+    }
+
+    // Bootknife resampling omits the systematically chosen sample index
+    {
+        size_t n = 5, nboot = 20;
+        vector<size_t> bootsam = draw (n, nboot, true, 1);
+        for ( size_t b = 0; b < nboot - 1; b++ ) {
+            for ( size_t i = 0; i < n; i++ ) CHECK (bootsam[b * n + i] != b % n);
+        }
+    }
+
+    // Weights set the number of times that each index is represented
+    {
+        size_t n = 4, nboot = 10;
+        vector<long long int> counts = {0, 20, 15, 5};
+        vector<size_t> bootsam = draw (n, nboot, false, 1, counts);
+        vector<long long int> count (n, 0);
+        for ( size_t k = 0; k < n * nboot; k++ ) count[bootsam[k]]++;
+        CHECK (count == counts);
+    }
+
+    // Resamples written using a callback match the resampled indices
+    {
+        vector<double> x = {1.5, 2.5, -3, 4};
+        BalancedSampler sampler (4, 3, false, 1);
+        vector<size_t> bootsam = draw (4, 3, false, 1);
+        for ( size_t b = 0; b < 3; b++ ) {
+            double col[4];
+            sampler.next ([&] (size_t i, size_t j) { col[i] = x[j]; });
+            for ( size_t i = 0; i < 4; i++ ) CHECK (col[i] == x[bootsam[b * 4 + i]]);
+            double y[4];
+            gather (y, x.data (), &bootsam[b * 4], 4);
+            CHECK (memcmp (y, col, sizeof (col)) == 0);
+        }
+        CHECK (sampler.drawn () == 3);
+    }
+
+    // The random numbers (generated in blocks) match those of std::mt19937_64
+    for ( unsigned int seed : {0u, 1u, 5489u, 4294967295u} ) {
+        MersenneTwister rng (seed);
+        mt19937_64 ref (seed);
+        bool same = true;
+        for ( int k = 0; k < 2000; k++ ) same = same && ( rng () == ref () );
+        CHECK (same);
+    }
+
+    // Instrumentation counts the draws and does not change the resamples
+    {
+        BootProfile prof;
+        BalancedSampler sampler (5, 20, false, 1);
+        sampler.set_profile (&prof);
+        vector<size_t> bootsam (5 * 20);
+        for ( size_t b = 0; b < 20; b++ ) sampler.next (&bootsam[b * 5]);
+        CHECK (bootsam == draw (5, 20, false, 1));
+        CHECK (prof.draws == 100);
+        CHECK (prof.steps >= 100 && prof.steps <= 500);
+        CHECK (prof.rng >= 0 && prof.search >= 0);
+    }
+
+    // The search for sampled indices matches a linear search of the counts
+    {
+        vector<long long int> c (40);
+        for ( size_t j = 0; j < c.size (); j++ ) c[j] = (j * 7) % 5;
+        long long int total = 0;
+        for ( size_t j = 0; j < c.size (); j++ ) total += c[j];
+        for ( long long int k = 0; k <= total; k++ ) {
+            size_t j = 0;
+            long long int d = c[0];
+            while ( j < c.size () && k >= d ) {
+                j++;
+                if ( j < c.size () ) d += c[j];
+            }
+            CHECK (balanced_search (c.data (), c.size (), k) == j);
+        }
+    }
+
+    // Invalid arguments
+    {
+        bool thrown = false;
+        try {
+            BalancedSampler sampler (3, 2, false, 1, vector<long long int> (3, 1));
+        } catch (const invalid_argument &) {
+            thrown = true;
+        }
+        CHECK (thrown);
+        thrown = false;
+        BalancedSampler sampler (3, 1, false, 1);
+        size_t idx[3];
+        sampler.next (idx);
+        try {
+            sampler.next (idx);
+        } catch (const out_of_range &) {
+            thrown = true;
+        }
+        CHECK (thrown);
+    }
+
+    // Binary file format
+    {
+        FILE *fid = tmpfile ();
+        double col[3] = {1, 2, 300};
+        CHECK (bootmat_index_type (255) == BOOTMAT_UINT8);
+        CHECK (bootmat_index_type (256) == BOOTMAT_UINT16);
+        CHECK (bootmat_index_type (70000) == BOOTMAT_UINT32);
+        CHECK (write_bootmat_header (fid, BOOTMAT_UINT16, 3, 1));
+        CHECK (write_bootmat_column (fid, col, 3, BOOTMAT_UINT16));
+        rewind (fid);
+        char magic[8];
+        uint32_t type, reserved;
+        uint64_t rows, cols;
+        uint16_t val[3];
+        CHECK (fread (magic, 1, 8, fid) == 8 && memcmp (magic, "BOOTMAT1", 8) == 0);
+        CHECK (fread (&type, 4, 1, fid) == 1 && type == BOOTMAT_UINT16);
+        CHECK (fread (&reserved, 4, 1, fid) == 1 && reserved == 0);
+        CHECK (fread (&rows, 8, 1, fid) == 1 && rows == 3);
+        CHECK (fread (&cols, 8, 1, fid) == 1 && cols == 1);
+        CHECK (fread (val, 2, 3, fid) == 3 && val[2] == 300);
+        fclose (fid);
+    }
+
+}
+
+
+static void test_smoothmedian ()
+{
+
+    double M;
+    bool failed;
+
+    // The smoothed median of symmetric data is the median
+    {
+        vector<double> x = {5, 1, 4, 2, 3};
+        smoothmed (x, 0, false, M, failed);
+        CHECK (fabs (M - 3) < 1e-12 && !failed);
+    }
+
+    // NaN values are ignored
+    {
+        vector<double> x = {1, NAN, 2, 10};
+        vector<double> y = {1, 2, 10};
+        double My;
+        smoothmed (x, 0, false, M, failed);
+        smoothmed (y, 0, false, My, failed);
+        CHECK (M == My);
+        x.assign (3, NAN);
+        smoothmed (x, 0, false, M, failed);
+        CHECK (M != M);
+    }
+
+    // The smoothed median is the root of the first derivative of the objective
+    // function, and is the same for each column/row regardless of the number
+    // of threads
+    {
+        int m = 101, n = 16;
+        mt19937 rng (1);
+        exponential_distribution<double> dist;
+        vector<double> x (m * n), xt (m * n);
+        for ( int k = 0; k < m * n; k++ ) x[k] = dist (rng);
+        for ( int k = 0; k < n; k++ ) {
+            for ( int j = 0; j < m; j++ ) xt[j * n + k] = x[k * m + j];
+        }
+        vector<double> M1 (n), M2 (n), M3 (n);
+        vector<char> f1 (n), f2 (n), f3 (n);
+        ThreadPool pool;
+        pool.resize (4);
+        smoothmedian (x.data (), m, n, 1, 1e-12, true, M1.data (), f1.data ());
+        smoothmedian (x.data (), m, n, 1, 1e-12, true, M2.data (), f2.data (), &pool);
+        smoothmedian (xt.data (), m, n, 2, 1e-12, true, M3.data (), f3.data (), &pool);
+        CHECK (M1 == M2);
+        CHECK (M1 == M3);
+        SmoothmedProfile prof;
+        vector<double> M4 (n);
+        smoothmedian (x.data (), m, n, 1, 1e-12, true, M4.data (), f1.data (), &pool, &prof);
+        CHECK (M1 == M4);
+        CHECK (prof.iterations >= (unsigned long long) n);
+        CHECK (prof.iterations <= prof.newton_steps + prof.bisection_steps + n);
+        CHECK (prof.pairs == prof.iterations * m * (m - 1) / 2);
+        CHECK (prof.busy <= prof.capacity);
+        for ( int k = 0; k < n; k++ ) {
+            const double *xk = &x[k * m];
+            double T = 0, S = 0;
+            for ( int j = 0; j < m; j++ ) {
+                for ( int i = 0; i < j; i++ ) {
+                    double R = sqrt (pow (xk[i] - M1[k], 2) + pow (xk[j] - M1[k], 2));
+                    T += (2 * M1[k] - xk[i] - xk[j]) / R;
+                    S += 1;
+                }
+            }
+            CHECK (fabs (T / S) < 1e-8);
+        }
+    }
+
+    // An exception thrown by a task is rethrown by the pool in the calling
+    // thread once all of the threads have stopped, and the pool can be reused
+    {
+        ThreadPool pool;
+        pool.resize (4);
+        atomic<int> count (0);
+        bool thrown = false;
+        try {
+            pool.run (1000, [&] (int k) {
+                count++;
+                if ( k == 10 ) throw runtime_error ("task failed");
+            });
+        } catch (const runtime_error &e) {
+            thrown = ( strcmp (e.what (), "task failed") == 0 );
+        }
+        CHECK (thrown);
+        count = 0;
+        pool.run (1000, [&] (int) { count++; });
+        CHECK (count == 1000);
+    }
+
+}
+
+
+// Returns the time taken (in seconds) by f (), taking the best of 3 runs
+template <typename F>
+static double timeit (F f)
+{
+    double best = 0;
+    for ( int rep = 0; rep < 3; rep++ ) {
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now ();
+        f ();
+        chrono::duration<double> dt = chrono::steady_clock::now () - t0;
+        if ( rep == 0 || dt.count () < best ) best = dt.count ();
+    }
+    return best;
+}
+
+
+// Prints (and appends to the CSV file csv, if not NULL) the result of a case
+static void report (FILE *csv, const char *func, const char *size, int nthreads,
+                    double t, double work, const char *units)
+{
+    printf ("%-14s %-34s %8d %12.6f %14.4g %s\n", func, size, nthreads, t,
+            work / t, units);
+    if ( csv != NULL ) {
+        fprintf (csv, "\"%s\",\"%s\",%d,%.6g,%.6g,\"%s\"\n", func, size,
+                 nthreads, t, work / t, units);
+    }
+}
+
+
+static void bench (FILE *csv)
+{
+
+    printf ("%-14s %-34s %8s %12s %14s\n", "function", "size", "threads",
+            "time (s)", "throughput");
+
+    // Balanced bootstrap and bootknife resampling, with uniform or non-uniform
+    // weights
+    size_t ns[] = {20, 200, 2000};
+    for ( size_t n : ns ) {
+        for ( int loo = 0; loo < 2; loo++ ) {
+            for ( int w = 0; w < 2; w++ ) {
+                size_t nboot = 1999;
+                vector<long long int> counts;
+                if ( w ) {
+                    counts.assign (n, nboot);
+                    for ( size_t i = 0; i + 1 < n; i += 2 ) {
+                        counts[i] -= nboot / 2;
+                        counts[i + 1] += nboot / 2;
+                    }
+                }
+                vector<size_t> idx (n);
+                double t = timeit ([&] {
+                    BalancedSampler sampler (n, nboot, loo, 1, counts);
+                    for ( size_t b = 0; b < nboot; b++ ) sampler.next (idx.data ());
+                });
+                char size[64];
+                snprintf (size, 64, "n=%zu nboot=%zu loo=%d %s", n, nboot, loo,
+                          w ? "weighted" : "uniform");
+                report (csv, "boot", size, 1, t, nboot, "resamples/s");
+            }
+        }
+    }
+
+    // Random numbers generated one at a time (std::mt19937_64) or in blocks
+    {
+        size_t ndraws = 10000000;
+        volatile unsigned long long sink = 0;   // Keeps the draws
+        double t = timeit ([&] {
+            mt19937_64 rng (1);
+            unsigned long long sum = 0;
+            for ( size_t k = 0; k < ndraws; k++ ) sum += rng ();
+            sink = sum;
+        });
+        report (csv, "rng", "std::mt19937_64", 1, t, ndraws, "draws/s");
+        t = timeit ([&] {
+            MersenneTwister rng (1);
+            unsigned long long sum = 0;
+            for ( size_t k = 0; k < ndraws; k++ ) sum += rng ();
+            sink = sum;
+        });
+        report (csv, "rng", "MersenneTwister", 1, t, ndraws, "draws/s");
+    }
+
+    // Smoothed median of each column, with 1, 2, 4, ... threads
+    int ncpus = max (1, (int) thread::hardware_concurrency ());
+    vector<int> threads;
+    for ( int nthreads = 1; nthreads < ncpus; nthreads *= 2 ) {
+        threads.push_back (nthreads);
+    }
+    threads.push_back (ncpus);
+    ThreadPool pool;
+    int ms[] = {20, 200, 1000};
+    for ( int m : ms ) {
+        int n = 199;
+        mt19937 rng (1);
+        normal_distribution<double> dist;
+        vector<double> x ((size_t) m * n), M (n);
+        vector<char> failed (n);
+        for ( size_t k = 0; k < x.size (); k++ ) x[k] = dist (rng);
+        for ( int nthreads : threads ) {
+            pool.resize (nthreads);
+            double t = timeit ([&] {
+                smoothmedian (x.data (), m, n, 1, 0, false, M.data (),
+                              failed.data (), nthreads > 1 ? &pool : NULL);
+            });
+            char size[64];
+            snprintf (size, 64, "m=%d n=%d", m, n);
+            report (csv, "smoothmedian", size, nthreads, t, n, "columns/s");
+        }
+    }
+
+}
+
+
+int main (int argc, char *argv[])
+{
+
+    if ( argc > 1 && strcmp (argv[1], "bench") == 0 ) {
+        FILE *csv = NULL;
+        if ( argc > 2 ) {
+            csv = fopen (argv[2], "a");
+            if ( csv == NULL ) {
+                printf ("Could not open %s for writing\n", argv[2]);
+                return 1;
+            }
+            if ( ftell (csv) == 0 ) {
+                fprintf (csv, "function,size,threads,time,throughput,units\n");
+            }
+        }
+        bench (csv);
+        if ( csv != NULL ) fclose (csv);
+        return 0;
+    }
+
+    test_boot ();
+    test_smoothmedian ();
+    if ( nfail > 0 ) {
+        printf ("%d test(s) failed\n", nfail);
+        return 1;
+    }
+    printf ("All tests passed\n");
+    return 0;
+
+}
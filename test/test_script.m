@@ -10,6 +10,12 @@ try
   boot (3, 20, true, 1);
   boot (3, 20, [], 1);
   boot (3, 20, true, 1, [30,30,0]);
+  f = tempname ();
+  boot (300, 20, false, 1, [], f);
+  bootread (f, 5:10);
+  bootwrite (f, rand (5, 10));
+  bootwrite (f, rand (5, 10), [], true);
+  delete (f);
 
   % bootknife 
   % bootknife:test:1
@@ -125,8 +131,12 @@ try
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'bca');
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'stud');
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'stud', 'nbootstd', 100);
+  bootci (1999, {@mean, y}, 'type', 'stud', 'stderr', 'jack');
+  bootci (1999, {{@var, 1}, y}, 'type', 'stud', 'stderr', 'jack');
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'cal');
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'cal', 'nbootcal', 199);
+  bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'cal', 'nbootcal', 199, ...
+          'checkpoint', cat (2, tempname (), '.mat'));
   g = reshape (repmat ((1:5), 4, 1), 20, []);
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'strata', []);
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'norm', 'strata', g);
@@ -134,6 +144,7 @@ try
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'basic', 'strata', g);
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'bca', 'strata', g);
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'stud', 'strata', g);
+  bootci (1999, {@mean, y}, 'type', 'stud', 'stderr', 'jack', 'strata', g);
   bootci (1999, {@mean, y}, 'alpha', 0.1, 'type', 'cal', 'strata', g);
   % bootci:test:2
   Y = randn (20); 
@@ -162,6 +173,7 @@ try
   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'basic');
   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'bca');
   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'stud');
+  bootci (1999, {@mldivide, X, y}, 'type', 'stud', 'stderr', 'jack');
   bootci (1999, {@mldivide, X, y}, 'alpha', 0.1, 'type', 'cal');
   
   % bootstrp:test:1
@@ -191,6 +203,11 @@ try
   bootstrp (50, @(x, y) mldivide (x, cell2mat (y)), ...
                            cat (2, ones (20, 1), X), num2cell (Y, 2));
   bootstrp (50, @mean, X, 'seed', 1);
+  f = {cat(2, tempname (), '.mat'), cat(2, tempname (), '.mat')};
+  bootstrp (50, @mean, X, 'seed', 1, 'shard', [1, 2], 'file', f{1});
+  bootstrp (50, @mean, X, 'seed', 1, 'shard', [2, 2], 'file', f{2});
+  [bootstat, bootsam, stats] = bootmerge (f);
+  cellfun (@delete, f);
   bootstrp (50, @mean, X, 'loo', false);
   bootstrp (50, @mean, X, 'Weights', rand (20, 1));
   bootstrp (50, @mean, X, 'seed', 1, 'loo', false, 'Weights', rand (20, 1));
@@ -288,6 +305,7 @@ try
   stats = bootwild (heights - H0, [], 2);
   stats = bootwild (heights - H0, [], [1;1;2;2;3;3;4;4;5;5]);
   stats = bootwild (heights - H0, [], [], 2000);
+  stats = bootwild (heights - H0, [], [], [2000, 0.05]);
   stats = bootwild (heights - H0, [], [], [], 0.05);
   stats = bootwild (heights - H0, [], [], [], [0.025, 0.975]);
   stats = bootwild (heights - H0, [], [], [], [], 1);
@@ -324,6 +342,7 @@ try
   stats = bootbayes (heights, ones (10, 1));
   stats = bootbayes (heights, [], 2);
   stats = bootbayes (heights, [], [1;1;2;2;3;3;4;4;5;5]);
+  stats = bootbayes (heights, [], [], [2000, 0.05]);
   stats = bootbayes (heights, [], [], 2000);
   stats = bootbayes (heights, [], [], [], 0.05);
   stats = bootbayes (heights, [], [], [], [0.025, 0.975]);